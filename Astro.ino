@@ -241,45 +241,99 @@ double jd2gast(double JulianDay, double ut1) {
   return timeRange(gast);
 }
 
-// convert date/time to Local Apparent Sidereal Time
+// convert date/time to Local Apparent Sidereal Time, ut1 is the time base in uS past 0h of the JulianDay date
 // optionally updates the RTC, uses longitude
-double jd2last(double JulianDay, double ut1, bool updateRTC) {
+double jd2last(double JulianDay, int64_t ut1, bool updateRTC) {
   if (updateRTC) {
-    // UT to local time
-    double lmt=ut1-timeZone;
-
-    // correct for day moving forward/backward... this works for multipule days of up-time
-    double J=JulianDay;
-    while (lmt >= 24.0) { lmt=lmt-24.0; J=J-1.0; } 
-    if    (lmt < 0.0)   { lmt=lmt+24.0; J=J+1.0; }
+    // UT to local time, whole days move the date
+    double J, lmt;
+    splitDay(ut1-(int64_t)floor(timeZone*3600000000.0+0.5),JulianDay,&J,&lmt);
 
     // set the RTC
     tls.setTimeZone(timeZone);
     tls.set(J,lmt);
   }
   // JulianDay is the Local date, jd2gast requires a universal time
-  // this is a hack that leaves the date alone and lets the UT1 cover
-  // the difference in time to the next (or previous) day
-  double gast=jd2gast(JulianDay,ut1);
+  // the whole days of UT1 go to the date and jd2gast gets the time within that day
+  double J, h;
+  splitDay(ut1,JulianDay,&J,&h);
+  double gast=jd2gast(J,h);
   return timeRange(gast-(longitude/15.0));
 }
 
+// takes the whole days out of a time in uS, leaving 0 to 24 hours, returns the days
+long takeDays(int64_t *t) {
+  const int64_t day=86400000000LL;
+  long d=(long)(*t/day); *t-=(int64_t)d*day;
+  if (*t < 0) { *t+=day; d--; }
+  return d;
+}
+
+// splits a time in uS past 0h of the JulianDay date into the date J and hours h (0 to 24) on that date
+void splitDay(int64_t t, double JulianDay, double *J, double *h) {
+  *J=JulianDay+takeDays(&t);
+  *h=(long)(t/1000000LL)/3600.0+(long)(t%1000000LL)/3600000000.0;
+}
+
+// UT1 time base, seconds and uS past 0h of the JD+UT1_days date, the fraction of a uS is in millionths
+long utSeconds=0;
+long utMicros=0;
+long utFraction=0;
+long utLst=0;                                                // the lst the time base was last brought up to
+
+// advances the UT1 time base by cs sidereal centi-seconds (1 sidereal cs = 9972.695663 uS) in 32 bit integer math
+void utAdvance(long cs) {
+  while (cs != 0) {
+    long n=cs; if (n > 1000) n=1000; if (n < -1000) n=-1000; cs-=n;
+    utFraction+=n*695663L;
+    long us=n*9972L+utFraction/1000000L; utFraction%=1000000L;
+    if (utFraction < 0) { utFraction+=1000000L; us--; }
+    utMicros+=us;
+    utSeconds+=utMicros/1000000L; utMicros%=1000000L;
+    if (utMicros < 0) { utMicros+=1000000L; utSeconds--; }
+    UT1_days+=utSeconds/86400L; utSeconds%=86400L;
+    if (utSeconds < 0) { utSeconds+=86400L; UT1_days--; }
+  }
+}
+
+// sets the UT1 time base, ut1 is in hours past 0h of the JD date (LMT+timeZone, so it can be below 0 or past 24)
+void setUT1(double ut1) {
+  int64_t t=(int64_t)floor(ut1*3600000000.0+0.5);
+  long d=takeDays(&t);
+  cli(); utLst=lst; sei();
+  UT1_days=d; utSeconds=(long)(t/1000000LL); utMicros=(long)(t%1000000LL); utFraction=0;
+  UT1=utSeconds/3600.0+utMicros/3600000000.0;
+}
+
+// brings UT1 up to date with the sidereal clock, UT1 is only ever the time within the day
+void updateUT1() {
+  cli(); long cs=lst; sei();
+  utAdvance(cs-utLst); utLst=cs;
+  UT1=utSeconds/3600.0+utMicros/3600000000.0;
+}
+
+// the UT1 time base now, in uS past 0h of the JD date
+int64_t ut1Micros() {
+  updateUT1();
+  return (int64_t)UT1_days*86400000000LL+(int64_t)utSeconds*1000000LL+utMicros;
+}
+
 // passes Local Apparent Sidereal Time to stepper timer
 void updateLST(double t) {
   long lst1=(t/24.0)*8640000.0;
 
-  // set the local sidereal time
+  // set the local sidereal time, the time base is brought up to the old lst then follows the new one
   cli(); 
+  long cs=lst;
   lst=lst1;
   sei();
-  UT1_start=UT1;
-  lst_start=lst1;
+  utAdvance(cs-utLst); utLst=lst1;
 }
 
-// convert the lst (in 1/100 second units) into floating point hours
+// convert the lst (in 1/100 second units) into floating point hours, the day is taken out in integer math
 double LST() {
   cli(); long tempLst=lst; sei();
-  while (tempLst > 8640000) tempLst-=8640000;
+  tempLst%=8640000L; if (tempLst < 0) tempLst+=8640000L;
   return (tempLst/8640000.0)*24.0;
 }
 
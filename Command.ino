@@ -252,6 +252,9 @@ void processCommands() {
           newTargetRA=origTargetRA; newTargetDec=origTargetDec;
 #if TELESCOPE_COORDINATES == TOPOCENTRIC
           topocentricToObservedPlace(&newTargetRA,&newTargetDec);
+#elif TELESCOPE_COORDINATES == ASTROMETRIC_J2000
+          j2000ToApparent(&newTargetRA,&newTargetDec);
+          topocentricToObservedPlace(&newTargetRA,&newTargetDec);
 #endif
 
           CommandErrors e;
@@ -412,6 +415,71 @@ void processCommands() {
 //                    1 on success
         if (toupper(command[1]) == 'D') { long l = atol(parameter)*spm; if (!foc->setTcfDeadband(l)) commandError=CE_PARAM_RANGE; } else
 
+// :FO#       Get focus model status
+//            Returns: m,n,t,r# where m=1 if temperature compensation uses the focus model, n samples, t terms fitted, r rms residual in microns
+        if (command[1] == 'O' && parameter[0] == 0) {
+          focusModel *m = foc->getFocusModel();
+          char rs[12]; dtostrf(m->getRms()/foc->getStepsPerMicro(),1,1,rs);
+          sprintf(reply,"%d,%d,%d,%s",(int)foc->getTcfModel(),m->getCount(),m->getTerms(),rs); boolReply=false;
+        } else
+// :FO[n]#    Set temperature compensation by coefficient (n=0) or by focus model (n=1), while compensation is disabled
+//            Return: 0 on failure
+//                    1 on success
+        if (command[1] == 'O') { if ((parameter[0] != '0' && parameter[0] != '1') || parameter[1] != 0 || !foc->setTcfModel(parameter[0] == '1')) commandError=CE_PARAM_RANGE; } else
+// :FW#       Get focuser filter slot for the focus model
+//            Returns: n#
+        if (command[1] == 'W' && parameter[0] == 0) { sprintf(reply,"%d",foc->getFilter()); boolReply=false; } else
+// :FW[n]#    Set focuser filter slot for the focus model, where [n] = 0 to 7
+//            Return: 0 on failure
+//                    1 on success
+        if (command[1] == 'W') { if (parameter[0] < '0' || parameter[0] > '9' || parameter[1] != 0 || !foc->setFilter(parameter[0]-'0')) commandError=CE_PARAM_RANGE; } else
+// :FK#       Add a focus model sample at the current position, temperature, altitude, and filter slot (at best focus)
+//            Return: 0 on failure
+//                    1 on success
+// :FK!#      Clear the focus model samples
+//            Return: 1
+        if (command[1] == 'K') {
+          if (parameter[0] == 0) { if (!foc->addFocusSample()) commandError=CE_0; } else
+          if (parameter[0] == '!' && parameter[1] == 0) foc->clearFocusSamples(); else commandError=CE_PARAM_RANGE;
+        } else
+// :FJ[n]#    Get focus model sample [n], where [n] = 0 (oldest) to 7
+//            Returns: t,a,f,p# temperature in deg. C, altitude in degrees, filter slot, position in microns
+        if (command[1] == 'J') {
+          float t, a; int fs; long p;
+          if (parameter[0] >= '0' && parameter[0] <= '9' && parameter[1] == 0 && foc->getFocusModel()->getSample(parameter[0]-'0',&t,&a,&fs,&p)) {
+            char ts[12]; dtostrf(t,1,1,ts);
+            sprintf(reply,"%s,%d,%d,%ld",ts,(int)a,fs,(long)round(p/spm)); boolReply=false;
+          } else commandError=CE_PARAM_RANGE;
+        } else
+
+// :FV#       Get autofocus status
+//            Returns: s,n,m,t,b,v# where s=0 idle, 1 moving, 2 waiting for a measurement, 3 moving to best focus, 4 done, 5 failed
+//                     n points measured of m planned, t target and b best focus positions in microns, v best fitted value
+// :FVS[n],[m]# or :FVS[n],[m],P#
+//            Start autofocus about the current position with [n] microns between [m] = 5 to 15 points, P fits a parabola not a hyperbola
+//            Return: 0 on failure
+//                    1 on success
+// :FVM[n.n]# Autofocus measurement (HFR or FWHM) at the current point
+//            Return: 0 on failure
+//                    1 on success
+// :FVP[n]#   Get autofocus point [n]
+//            Returns: p,v# position in microns, measurement
+// :FVQ#      Stop autofocus and return to the starting position
+//            Returns: Nothing
+        if (command[1] == 'V') {
+          if (parameter[0] == 0) { autofocus.status(reply,foc->getStepsPerMicro()); boolReply=false; } else
+          if (parameter[0] == 'S') {
+            double s=strtod(&parameter[1],&conv_end);
+            long n=0; AutofocusFit fit=AF_HYPERBOLA;
+            if (*conv_end == ',') n=strtol(conv_end+1,&conv_end,10);
+            if (conv_end[0] == ',' && conv_end[1] == 'P' && conv_end[2] == 0) { fit=AF_PARABOLA; conv_end+=2; }
+            if (*conv_end != 0 || !autofocus.start(foc,lround(s*foc->getStepsPerMicro()),n,fit)) commandError=CE_PARAM_RANGE;
+          } else
+          if (parameter[0] == 'M') { if (!autofocus.measure(atof(&parameter[1]))) commandError=CE_0; } else
+          if (parameter[0] == 'P') { if (!autofocus.point(atol(&parameter[1]),reply,foc->getStepsPerMicro())) commandError=CE_PARAM_RANGE; else boolReply=false; } else
+          if (parameter[0] == 'Q' && parameter[1] == 0) { autofocus.abort(); boolReply=false; } else commandError=CE_CMD_UNKNOWN;
+        } else
+
 // :FP#       Get focuser DC Motor Power Level (in %)
 //            Returns: n#
 // :FP[n]#    Set focuser DC Motor Power Level (in %)
@@ -498,11 +566,11 @@ void processCommands() {
 //            Returns: MM/DD/YY#
       if (command[1] == 'C' && parameter[0] == 0) { 
         LMT=UT1-timeZone;
-        // correct for day moving forward/backward... this works for multipule days of up-time
-        double J=JD;
+        // correct for day moving forward/backward... UT1 is within the day and UT1_days has the rest of the up-time
+        double J=JD+UT1_days;
         int y,m,d;
-        while (LMT >= 24.0) { LMT=LMT-24.0; J=J-1.0; } 
-        if    (LMT<0.0)   { LMT=LMT+24.0; J=J+1.0; }
+        if (LMT >= 24.0) { LMT=LMT-24.0; J=J+1.0; } 
+        if (LMT < 0.0)   { LMT=LMT+24.0; J=J-1.0; }
         greg(J,&y,&m,&d); y-=2000; if (y >= 100) y-=100;
         sprintf(reply,"%02d/%02d/%02d",m,d,y); 
         boolReply=false; 
@@ -527,6 +595,9 @@ void processCommands() {
           getEqu(&f,&f1,false);
 #if TELESCOPE_COORDINATES == TOPOCENTRIC
           observedPlaceToTopocentric(&f,&f1);
+#elif TELESCOPE_COORDINATES == ASTROMETRIC_J2000
+          observedPlaceToTopocentric(&f,&f1);
+          apparentToJ2000(&f,&f1);
 #endif
           _ra=f/15.0; _dec=f1; _coord_t=millis(); 
         }
@@ -599,8 +670,8 @@ void processCommands() {
 //            Returns: HH:MM:SS#
 // :GLH#      Get Local Time in 24 hour format
 //            Returns: HH:MM:SS.SSSS# (high precision)
-//            On devices with single precision fp several days up-time will cause loss of precision as additional mantissa digits are needed to represent hours
-//            Devices with double precision fp are limitated by sidereal clock overflow which takes 249 days
+//            UT1 comes from an integer time base and is kept within the day so up-time doesn't cause loss of precision, even on devices with single precision fp
+//            Up-time is limitated by sidereal clock overflow which takes 249 days
       if (command[1] == 'L') {
         LMT=timeRange(UT1-timeZone);
         if ( parameter[0] == 0)  {
@@ -648,6 +719,9 @@ void processCommands() {
           getEqu(&f,&f1,false);
 #if TELESCOPE_COORDINATES == TOPOCENTRIC
           observedPlaceToTopocentric(&f,&f1);
+#elif TELESCOPE_COORDINATES == ASTROMETRIC_J2000
+          observedPlaceToTopocentric(&f,&f1);
+          apparentToJ2000(&f,&f1);
 #endif
           _ra=f/15.0; _dec=f1; _coord_t=millis(); 
         }
@@ -903,7 +977,7 @@ void processCommands() {
           if (parameter[0] == '8') { // 8n: Date/Time
             switch (parameter[1]) {
               case '0': f=timeRange(UT1); doubleToHms(reply,&f,PM_HIGH); boolReply=false; break;          // UTC time
-              case '1': f1=JD; f=UT1; while (f >= 24.0) { f-=24.0; f1+=1; } while (f < 0.0) { f+=24.0; f1-=1; } greg(f1,&i2,&i,&i1); i2=(i2/99.99999-floor(i2/99.99999))*100; sprintf(reply,"%02d/%02d/%02d",i,i1,i2); boolReply=false; break; // UTC date
+              case '1': f1=JD+UT1_days; f=UT1; while (f >= 24.0) { f-=24.0; f1+=1; } while (f < 0.0) { f+=24.0; f1-=1; } greg(f1,&i2,&i,&i1); i2=(i2/99.99999-floor(i2/99.99999))*100; sprintf(reply,"%02d/%02d/%02d",i,i1,i2); boolReply=false; break; // UTC date
               case '9': if (dateWasSet && timeWasSet) commandError=CE_0; break;                              // Get Date/Time status, returns 0=known or 1=unknown
               default:  commandError=CE_CMD_UNKNOWN;
             }
@@ -939,6 +1013,12 @@ void processCommands() {
               case 'D': dtostrf(ambient.getAltitude(),3,1,reply); boolReply=false; break;                 // altitude in meters
               case 'E': dtostrf(ambient.getDewPoint(),3,1,reply); boolReply=false; break;                 // dew point in deg. C
               case 'F': { float t=HAL_MCU_Temperature(); if (t > -999) { dtostrf(t,1,0,reply); boolReply=false; } else commandError=CE_0; } break; // internal MCU temperature in deg. C
+              case 'G': sprintf(reply,"%d",(int)searchPattern); boolReply=false; break;                // search pattern 0=Archimedean, 1=square, 2=raster
+              case 'H': dtostrf(searchFov,1,1,reply); boolReply=false; break;                             // search FOV in arc-seconds
+              case 'I': sprintf(reply,"%d",(int)round(searchOverlap*100.0)); boolReply=false; break;      // search overlap in %
+#if PPS_SENSE != OFF
+              case 'J': ppsStatus(reply); boolReply=false; break;                                         // PPS lock state,ppm,phase us,RMS phase us
+#endif
               default:  commandError=CE_CMD_UNKNOWN;
             }
           } else
@@ -990,6 +1070,15 @@ void processCommands() {
                 boolReply=false;
 #else
                 commandError=CE_0;
+#endif
+              break;
+              case 'L':
+                // load sampled during gotos as sg1,sgMin1,cs1,sg2,sgMin2,cs2,goto rate in us/step (-1 if not sampled yet)
+#if AXIS1_DRIVER_STATUS == TMC_SPI && AXIS2_DRIVER_STATUS == TMC_SPI
+                loadStatus(reply);
+                boolReply=false;
+#else
+                commandError=CE_0;
 #endif
               break;
               default: commandError=CE_CMD_UNKNOWN;
@@ -1071,6 +1160,21 @@ void processCommands() {
               default:  commandError=CE_CMD_UNKNOWN;
             }
           } else
+#if PROFILER == ON
+          if (parameter[0] == 'P') { // Pn: get Profiler statistics
+            // n is the section number 0..9, returns name,count,average us,worst us,total ms
+            if (parameter[1] == '!') profiler.reset(); else
+            if (parameter[1] >= '0' && parameter[1] <= '9' && profiler.status(parameter[1]-'0',reply)) boolReply=false; else commandError=CE_0;
+          } else
+#endif
+          if (parameter[0] == 'T') { // Tn: get Task statistics
+            // n is the task number 0..9 or A..J, returns name,count,average us,max us,overruns
+            i=-1;
+            if (parameter[1] >= '0' && parameter[1] <= '9') i=parameter[1]-'0'; else
+            if (parameter[1] >= 'A' && parameter[1] <= 'J') i=parameter[1]-'A'+10; else
+            if (parameter[1] == '!') { tasks.resetStatus(); i=-2; }
+            if (i != -2) { if (tasks.status(i,reply)) boolReply=false; else commandError=CE_0; }
+          } else
 #ifdef FEATURES_PRESENT
           if (parameter[0] == 'X') { // Xn: get auXiliary feature
             featuresGetCommand(parameter,reply,boolReply);
@@ -1163,6 +1267,9 @@ void processCommands() {
         newTargetRA=origTargetRA; newTargetDec=origTargetDec;
 #if TELESCOPE_COORDINATES == TOPOCENTRIC
         topocentricToObservedPlace(&newTargetRA,&newTargetDec);
+#elif TELESCOPE_COORDINATES == ASTROMETRIC_J2000
+        j2000ToApparent(&newTargetRA,&newTargetDec);
+        topocentricToObservedPlace(&newTargetRA,&newTargetDec);
 #endif
 
         commandError=goToEqu(newTargetRA,newTargetDec);
@@ -1232,7 +1339,21 @@ void processCommands() {
       if (command[1] == 'N' && parameter[0] == 0) { 
           Lib.nextRec();
           boolReply=false;
-      } else 
+      } else
+
+// :LA#       Find the object in this catalog nearest the current pointing and set it as the current target object
+//            Return: 0 on failure (catalog empty)
+//                    1 on success
+      if (command[1] == 'A' && parameter[0] == 0) {
+          getEqu(&f,&f1,false);
+#if TELESCOPE_COORDINATES == TOPOCENTRIC
+          observedPlaceToTopocentric(&f,&f1);
+#elif TELESCOPE_COORDINATES == ASTROMETRIC_J2000
+          observedPlaceToTopocentric(&f,&f1);
+          apparentToJ2000(&f,&f1);
+#endif
+          if (!Lib.nearestRec(f,f1)) commandError=CE_0;
+      } else
 
 // :L$#       Move to catalog name record
 //            Returns: 1
@@ -1271,6 +1392,7 @@ void processCommands() {
 
 // :Lo[n]#    Select Library catalog by catalog number n
 //            Catalog number ranges from 0..14, catalogs 0..6 are user defined, the remainder are reserved
+//            With CATALOG_EXTERNAL, catalog numbers defined in the external catalog file are read from it instead (read only)
 //            Return: 0 on failure
 //                    1 on success
       if (command[1] == 'o') {
@@ -1297,6 +1419,7 @@ void processCommands() {
         commandError=e;
       } else
 // :Mgd[n]#   Pulse guide command where n is the guide time in milliseconds
+//            A pulse that arrives while another is running on the same axis is queued to follow it
 //            Returns: Nothing
 // :MGd[n]#   Pulse guide command where n is the guide time in milliseconds
 //            Return: 0 on failure
@@ -1304,25 +1427,48 @@ void processCommands() {
       if (command[1] == 'g' || command[1] == 'G') {
         if (atoi2((char *)&parameter[1],&i)) {
           if (i >= 0 && i <= 16399) {
-            if ((parameter[0] == 'e' || parameter[0] == 'w') && guideDirAxis1 == 0) {
+            if (parameter[0] == 'e' || parameter[0] == 'w') {
 #if SEPARATE_PULSE_GUIDE_RATE == ON
-              commandError=startGuideAxis1(parameter[0],currentPulseGuideRate,i,true);
+              commandError=pulseGuideAxis1(parameter[0],currentPulseGuideRate,i);
 #else
-              commandError=startGuideAxis1(parameter[0],currentGuideRate,i,true);
+              commandError=pulseGuideAxis1(parameter[0],currentGuideRate,i);
 #endif
               if (command[1] == 'g') boolReply=false;
             } else
-            if ((parameter[0] == 'n' || parameter[0] == 's') && guideDirAxis2 == 0) { 
+            if (parameter[0] == 'n' || parameter[0] == 's') { 
 #if SEPARATE_PULSE_GUIDE_RATE == ON
-              commandError=startGuideAxis2(parameter[0],currentPulseGuideRate,i,true);
+              commandError=pulseGuideAxis2(parameter[0],currentPulseGuideRate,i);
 #else
-              commandError=startGuideAxis2(parameter[0],currentGuideRate,i,true);
+              commandError=pulseGuideAxis2(parameter[0],currentGuideRate,i);
 #endif
               if (command[1] == 'g') boolReply=false;
             } else commandError=CE_CMD_UNKNOWN;
           } else commandError=CE_PARAM_RANGE;
         } else commandError=CE_PARAM_FORM;
       } else
+// :Mod[n.n]# Guide offset where d is the direction (e, w, n, or s) and n.n is the offset in arc-seconds
+// :MOd[n.n]# Guide offset where d is the direction (e, w, n, or s) and n.n is the offset in steps
+//            The offset is moved as an exactly timed guide at a rate shaped to finish within GUIDE_OFFSET_TIME_LIMIT ms
+//            so it can be at most GUIDE_OFFSET_RATE_MAX x sidereal for that time (60" with the defaults)
+//            Returns: Nothing
+      if (command[1] == 'o' || command[1] == 'O') {
+        f=strtod(&parameter[1],&conv_end);
+        if (&parameter[1] != conv_end && *conv_end == 0) {
+          if (f >= 0.0) {
+            if (parameter[0] == 'e' || parameter[0] == 'w') {
+              if (command[1] == 'o') f=f/arcSecPerStepAxis1;
+              if (parameter[0] == 'e') f=-f;
+              commandError=guideOffsetAxis1(f);
+            } else
+            if (parameter[0] == 'n' || parameter[0] == 's') {
+              if (command[1] == 'o') f=f/arcSecPerStepAxis2;
+              if (parameter[0] == 's') f=-f;
+              commandError=guideOffsetAxis2(f);
+            } else commandError=CE_CMD_UNKNOWN;
+          } else commandError=CE_PARAM_RANGE;
+        } else commandError=CE_PARAM_FORM;
+        boolReply=false;
+      } else
 // :Me# :Mw#  Move Telescope East or West at current guide rate
 //            Returns: Nothing
       if ((command[1] == 'e' || command[1] == 'w') && parameter[0] == 0) {
@@ -1336,9 +1482,14 @@ void processCommands() {
         boolReply=false;
       } else
 // :Mp#  Move Telescope for sPiral search at current guide rate
+// :Mp[p]#    Same but first select search pattern p: A=Archimedean spiral, S=square spiral, R=raster
 //            Returns: Nothing
-      if ((command[1] == 'p') && parameter[0] == 0) {
-        commandError=startGuideSpiral(currentGuideRate,GUIDE_SPIRAL_TIME_LIMIT*1000);
+      if ((command[1] == 'p') && (parameter[0] == 0 || parameter[1] == 0)) {
+        if (parameter[0] == 'A') searchPattern=SP_ARCHIMEDEAN; else
+        if (parameter[0] == 'S') searchPattern=SP_SQUARE; else
+        if (parameter[0] == 'R') searchPattern=SP_RASTER; else
+        if (parameter[0] != 0) commandError=CE_PARAM_RANGE;
+        if (commandError == CE_NONE) commandError=startGuideSpiral(currentGuideRate,GUIDE_SPIRAL_TIME_LIMIT*1000);
         boolReply=false;
       } else
 
@@ -1377,6 +1528,9 @@ void processCommands() {
         newTargetRA=origTargetRA; newTargetDec=origTargetDec;
 #if TELESCOPE_COORDINATES == TOPOCENTRIC
         topocentricToObservedPlace(&newTargetRA,&newTargetDec);
+#elif TELESCOPE_COORDINATES == ASTROMETRIC_J2000
+        j2000ToApparent(&newTargetRA,&newTargetDec);
+        topocentricToObservedPlace(&newTargetRA,&newTargetDec);
 #endif
         CommandErrors e=goToEqu(newTargetRA,newTargetDec);
         if (e >= CE_GOTO_ERR_BELOW_HORIZON && e <= CE_GOTO_ERR_UNSPECIFIED) reply[0]=(char)(e-CE_GOTO_ERR_BELOW_HORIZON)+'1';
@@ -1448,6 +1602,98 @@ void processCommands() {
         } else commandError=CE_CMD_UNKNOWN;
       } else
 
+#if GUIDE_CONTROL == ON
+// $G - Guide Control
+// :$GZ+      Start closed loop guiding
+//            Returns: nothing
+// :$GZ-      Stop closed loop guiding
+//            Returns: nothing
+// :$GZ?      Get guide control status
+//            Returns: e,n,e1,e2,r1,r2# enabled (0/1), measurements, estimated errors (arc-sec), correction rates (x sidereal)
+// :$GE[dx],[dy]#
+//            Centroid error in pixels from the guide camera
+//            Return: 0 on failure (not enabled)
+//                    1 on success
+// :$GM[m0],[m1],[m2],[m3]#
+//            Set calibration matrix in arc-seconds per pixel, where axis1=m0*dx+m1*dy and axis2=m2*dx+m3*dy
+//            Return: 0 on failure
+//                    1 on success
+// :$GK[kp],[ki],[kd],[ke]#
+//            Set PID gains and estimator gain ke (0 < ke <= 1)
+//            Return: 0 on failure
+//                    1 on success
+      if (command[0] == '$' && command[1] == 'G') {
+        double g[4];
+        int n=0;
+        if (parameter[0] == 'E' || parameter[0] == 'M' || parameter[0] == 'K') {
+          char *p=&parameter[1];
+          while (n < 4) {
+            g[n]=strtod(p,&conv_end); if (conv_end == p) break;
+            n++; p=conv_end;
+            if (*p == ',') p++; else break;
+          }
+          if (*conv_end != 0) n=0;
+        }
+        if (parameter[0] == 'Z' && parameter[2] == 0) {
+          boolReply=false;
+          if (parameter[1] == '+') guideControlStart(); else
+          if (parameter[1] == '-') guideControlStop(); else
+          if (parameter[1] == '?') guideControlStatus(reply); else { boolReply=true; commandError=CE_CMD_UNKNOWN; }
+        } else
+        if (parameter[0] == 'E') { if (n == 2) { if (!guideControlMeasurement(g[0],g[1])) commandError=CE_0; } else commandError=CE_PARAM_FORM; } else
+        if (parameter[0] == 'M') { if (n == 4) guideControlSetMatrix(g[0],g[1],g[2],g[3]); else commandError=CE_PARAM_FORM; } else
+        if (parameter[0] == 'K') { if (n == 4) { if (!guideControlSetGains(g[0],g[1],g[2],g[3])) commandError=CE_PARAM_RANGE; } else commandError=CE_PARAM_FORM; } else
+          commandError=CE_CMD_UNKNOWN;
+      } else
+#endif
+
+#if TELEMETRY_LOG != OFF
+// $L - Telemetry Log
+// :$LZ+      Start logging tracking/guiding samples (once every 1/100 second)
+//            Returns: nothing
+// :$LZ-      Stop logging
+//            Returns: nothing
+// :$LZZ      Clear the log
+//            Returns: nothing
+// :$LZ?      Get log status
+//            Returns: l,n,m,s# where l is logging (0/1), n is records in log, m is log capacity, s is record size in bytes
+// :$LZD      Dump the log
+//            Returns: n# where n is the number of records, followed by n binary records (oldest first, little-endian)
+//            Logging is paused until the dump completes, do not send other commands on this channel during the dump except :$LZX
+// :$LZX      Abort a dump that's underway
+//            Returns: nothing
+      if (command[0] == '$' && command[1] == 'L') {
+        if (parameter[0] == 'Z' && parameter[2] == 0) {
+          boolReply=false;
+          if (parameter[1] == '+') telemetryStart(); else
+          if (parameter[1] == '-') telemetryStop(); else
+          if (parameter[1] == 'Z') { if (!telemetryDumping()) telemetryClear(); else commandError=CE_0; } else
+          if (parameter[1] == '?') telemetryStatus(reply); else
+          if (parameter[1] == 'X') telemetryAbort(); else
+          if (parameter[1] == 'D') {
+            Stream *port=NULL;
+            if (process_command == COMMAND_SERIAL_A) port=&SerialA;
+#ifdef HAL_SERIAL_B_ENABLED
+            if (process_command == COMMAND_SERIAL_B) port=&SerialB;
+#endif
+#ifdef HAL_SERIAL_C_ENABLED
+            if (process_command == COMMAND_SERIAL_C) port=&SerialC;
+#endif
+#ifdef HAL_SERIAL_D_ENABLED
+            if (process_command == COMMAND_SERIAL_D) port=&SerialD;
+#endif
+#ifdef HAL_SERIAL_E_ENABLED
+            if (process_command == COMMAND_SERIAL_E) port=&SerialE;
+#endif
+            if (port != NULL && !telemetryDumping()) sprintf(reply,"%d",telemetryDump(port)); else commandError=CE_0;
+          } else {
+            boolReply=true;
+            commandError=CE_CMD_UNKNOWN;
+          }
+        } else commandError=CE_CMD_UNKNOWN;
+      } else
+#endif
+
 // Q - Movement Commands
 // :Q#        Halt all slews, stops goto
 //            Returns: Nothing
@@ -1662,7 +1908,9 @@ void processCommands() {
       if (command[1] == 'C')  {
         if (dateToDouble(&JD,parameter)) {
           nv.writeFloat(EE_JD,JD);
-          updateLST(jd2last(JD,UT1,true));
+          // the local time carries over to the new date
+          updateUT1(); setUT1(timeRange(UT1-timeZone)+timeZone);
+          updateLST(jd2last(JD,ut1Micros(),true));
           dateWasSet=true;
           if (generalError == ERR_SITE_INIT && dateWasSet && timeWasSet) generalError=ERR_NONE;
         } else commandError=CE_PARAM_FORM; } else 
@@ -1686,7 +1934,7 @@ void processCommands() {
             nv.writeFloat(EE_sites+currentSite*25+4,longitude);
           } else commandError=CE_PARAM_RANGE;
         } else commandError=CE_PARAM_FORM;
-        updateLST(jd2last(JD,UT1,false));
+        updateLST(jd2last(JD,ut1Micros(),false));
         } else
 //  :SG[sHH]# or :SG[sHH:MM]# (where MM is 30 or 45)
 //            Set the number of hours added to local time to yield UTC
@@ -1707,7 +1955,7 @@ void processCommands() {
               if (i<0) timeZone=i-f; else timeZone=i+f;
               b=encodeTimeZone(timeZone)+128;
               nv.update(EE_sites+currentSite*25+8,b);
-              updateLST(jd2last(JD,UT1,true));
+              updateLST(jd2last(JD,ut1Micros(),true));
             } else commandError=CE_PARAM_RANGE;
           } else commandError=CE_PARAM_FORM;
         } else commandError=CE_PARAM_FORM; 
@@ -1732,8 +1980,8 @@ void processCommands() {
 #ifndef ESP32
           nv.writeFloat(EE_LMT,LMT);
 #endif
-          UT1=LMT+timeZone;
-          updateLST(jd2last(JD,UT1,true));
+          setUT1(LMT+timeZone);
+          updateLST(jd2last(JD,ut1Micros(),true));
           timeWasSet=true;
           if (generalError == ERR_SITE_INIT && dateWasSet && timeWasSet) generalError=ERR_NONE;
         } else commandError=CE_PARAM_FORM;
@@ -1923,6 +2171,16 @@ void processCommands() {
                 ambient.setAltitude(f);
               } else commandError=CE_PARAM_RANGE;
             break;
+            case 'G': // search pattern 0=Archimedean, 1=square, 2=raster
+              if (parameter[3] >= '0' && parameter[3] <= '2' && parameter[4] == 0) searchPattern=(SearchPattern)(parameter[3]-'0'); else commandError=CE_PARAM_RANGE;
+            break;
+            case 'H': // search FOV in arc-seconds, 0 for automatic
+              f=strtod(&parameter[3],&conv_end);
+              if (&parameter[3] != conv_end && f >= 0.0 && f <= 36000.0) searchFov=f; else commandError=CE_PARAM_RANGE;
+            break;
+            case 'I': // search overlap in %
+              if (atoi2(&parameter[3],&i) && i >= 0 && i <= 50) searchOverlap=i/100.0; else commandError=CE_PARAM_RANGE;
+            break;
             default: commandError=CE_CMD_UNKNOWN;
           }
         } else
@@ -2227,7 +2485,7 @@ void processCommands() {
           timeZone=nv.read(EE_sites+currentSite*25+8)-128;
           timeZone=decodeTimeZone(timeZone);
           if (timeZone < -14 || timeZone > 12) { timeZone=0.0; DLF("ERR, processCommands(): bad NV timeZone"); }
-          updateLST(jd2last(JD,UT1,false));
+          updateLST(jd2last(JD,ut1Micros(),false));
         } else 
         if (command[1] == '?') {
           boolReply=false;
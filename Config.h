@@ -51,6 +51,10 @@
       #define SERIAL_GPS_BAUD         9600
     
 
+// OBJECT LIBRARY ------------------------------------------------------------------------------------------------------------------
+#define CATALOG_EXTERNAL              OFF //    OFF, n. Where n is the SD card CS pin, catalogs in file CATALOG.BIN replace   Option
+                                          //         the matching NV catalogs (:Lo[n]#) and are read only.
+
 // SENSORS -------------------------------------------------------- see https://onstep.groups.io/g/main/wiki/6-Configuration#SENSORS
 // * = also supports ON_PULLUP or ON_PULLDOWN to activate MCU internal resistors if present.
 #define WEATHER                       OFF //    OFF, BME280 (I2C 0x77,) BME280_0x76, BME280_SPI (see pinmap for CS.)          Option
@@ -86,6 +90,8 @@
 // GUIDING BEHAVIOUR ---------------------------------------------- see https://onstep.groups.io/g/main/wiki/6-Configuration#GUIDING
 #define GUIDE_TIME_LIMIT                0 //      0, No guide time limit. Or n. Where n=1..120 second time limit guard.       Adjust
 #define GUIDE_DISABLE_BACKLASH        OFF //    OFF, Disable backlash takeup during guiding at <= 1X                          Option
+#define GUIDE_CONTROL                 OFF //    OFF, ON closed loop guiding from centroid errors sent w/:$GE (1/100s PID.)    Option
+#define TELEMETRY_LOG                 OFF //    OFF, n. Where n=100..4000 records (20 bytes ea) of 1/100s track/guide log.    Option
 
 // TRACKING BEHAVIOUR -------------------------------------------- see https://onstep.groups.io/g/main/wiki/6-Configuration#TRACKING
 #define TRACK_AUTOSTART               OFF //    OFF, ON Start with tracking enabled.                                          Option
@@ -97,6 +103,7 @@
 #define SLEW_RATE_BASE_DESIRED        6 //    1.0, n. Desired slew rate in deg/sec. Adjustable at run-time from            <-Req'd
                                           //         1/2 to 2x this rate, and as MCU performace considerations require.
 #define SLEW_RATE_MEMORY              OFF //    OFF, ON Remembers rates set across power cycles.                              Option
+#define GOTO_RATE_ADAPTIVE            OFF //    OFF, ON goes up to 2x faster while TMC_SPI stallGuard shows load margin.      Option
 #define SLEW_ACCELERATION_DIST        5.0 //    5.0, n, (degrees.) Approx. distance for acceleration (and deceleration.)      Adjust
 #define SLEW_RAPID_STOP_DIST          2.5 //    2.0, n, (degrees.) Approx. distance required to stop when a slew              Adjust
                                           //         is aborted or a limit is exceeded.
@@ -199,6 +206,9 @@
 #define AXIS4_DRIVER_REVERSE          OFF //    OFF, ON Reverses movement direction, or reverse wiring instead to correct.    Option
 #define AXIS4_DRIVER_DC_MODE          OFF //    OFF, DRV8825 for pwm dc motor control on stepper driver outputs.              Option
 
+#define AXIS4_ACCEL_PROFILE     TRAPEZOID //TRAPEZOID, S_CURVE, or OFF for constant rate. Velocity profile of focuser moves.  Option
+#define AXIS4_ACCEL_TIME              250 //    250, n. Where n=10..5000 (ms.) Time to accelerate to the maximum rate.        Adjust
+
 #define AXIS4_LIMIT_MIN_RATE           50 //     50, n. Where n=1..1000 (um/s.) Minimum microns/second. In DC mode, min pwr.  Adjust
 #define AXIS4_LIMIT_MIN                 0 //      0, n. Where n=0..500 (millimeters.) Minimum allowed position.               Adjust
 #define AXIS4_LIMIT_MAX                50 //     50, n. Where n=0..500 (millimeters.) Maximum allowed position.               Adjust
@@ -217,6 +227,9 @@
 #define AXIS5_DRIVER_REVERSE          OFF //    OFF, ON Reverses movement direction, or reverse wiring instead to correct.    Option
 #define AXIS5_DRIVER_DC_MODE          OFF //    OFF, DRV8825 for pwm dc motor control on stepper driver outputs.              Option
 
+#define AXIS5_ACCEL_PROFILE     TRAPEZOID //TRAPEZOID, S_CURVE, or OFF for constant rate. Velocity profile of focuser moves.  Option
+#define AXIS5_ACCEL_TIME              250 //    250, n. Where n=10..5000 (ms.) Time to accelerate to the maximum rate.        Adjust
+
 #define AXIS5_LIMIT_MIN_RATE           50 //     50, n. Where n=1..1000 (um/s.) Minimum microns/second. In DC mode, min pwr.  Adjust
 #define AXIS5_LIMIT_MIN                 0 //      0, n. Where n=0..500 (millimeters.) Minimum allowed position.               Adjust
 #define AXIS5_LIMIT_MAX                50 //     50, n. Where n=0..500 (millimeters.) Maximum allowed position.               Adjust
@@ -138,6 +138,10 @@
 #define BD_IN -1
 #define BD_OUT 1
 
+// velocity profiles for focuser moves
+#define TRAPEZOID                   1
+#define S_CURVE                     2
+
 // EEPROM Info ---------------------------------------------------------------------------------------------------------------------
 // General purpose storage A (100 bytes), 0..99
 
@@ -218,7 +222,21 @@
 #define EE_pecTable                200
 
 // Library
-// Catalog storage starts at 200+pecBufferSize and ends at E2END-200
+// Catalog storage starts at 200+pecBufferSize and ends at E2END-557, NV written under NV_INIT_KEY_PREV has its library
+// records past that point dropped and general purpose storage C and D cleared at startup (see initWriteNvValues())
+
+// General purpose storage D (292 bytes), E2END-556..E2END-265, focus model A/B slot records (see src/lib/FocusModel.h)
+#define GSD                       (GSC-292)
+#define EE_focModelAxis4A          GSD+0   // 73
+#define EE_focModelAxis4B          GSD+73  // 73
+#define EE_focModelAxis5A          GSD+146 // 73
+#define EE_focModelAxis5B          GSD+219 // 73
+
+// General purpose storage C (64 bytes), E2END-264..E2END-201, versioned CRC protected A/B slot records
+#define GSC                       (GSB-64)
+#define EE_parkRecordA             GSC+0   // 32
+#define EE_parkRecordB             GSC+32  // 32
+#define NV_PARK_RECORD_VERSION     1
 
 // General purpose storage B (200 bytes), E2END-199..E2END
 #define GSB                       (E2END-200)
@@ -281,7 +299,9 @@
 
 // ---------------------------------------------------------------------------------------------------------------------------------
 // Unique identifier for the current initialization format for NV, do not change
-#define NV_INIT_KEY 915307551
+#define NV_INIT_KEY 915307552
+// Previous format, the library ran to E2END-200 before general purpose storage C and D were carved from its end
+#define NV_INIT_KEY_PREV 915307551
 
 #define PierSideNone               0
 #define PierSideEast               1
@@ -101,8 +101,12 @@
 #include "Globals.h"
 #include "src/lib/Julian.h"
 #include "src/lib/Misc.h"
+#include "src/lib/Scheduler.h"
+#include "src/lib/Profiler.h"
+#include "src/lib/NvRecord.h"
 #include "src/lib/Sound.h"
 #include "src/lib/Coord.h"
+#include "src/lib/Apparent.h"
 #include "Align.h"
 #include "src/lib/Library.h"
 #include "src/lib/Command.h"
@@ -139,6 +143,7 @@ weather ambient;
       focuserStepper foc2;
     #endif
   #endif
+  #include "src/lib/Autofocus.h"
 #endif
 
 // support for TMC2130, TMC5160, etc. stepper drivers in SPI mode
@@ -252,6 +257,10 @@ void setup() {
   }
   V(E2END+1); VLF(" Bytes");
 
+  // bulk load the general purpose storage areas (settings, sites, park record, focus models, etc.) into the NV cache
+  nv.preload(0,EE_pecTable);
+  nv.preload(GSD,E2END-GSD+1);
+
   // if this is the first startup set EEPROM to defaults
   initWriteNvValues();
 
@@ -365,6 +374,8 @@ void setup() {
   if (AXIS4_DRIVER_DC_MODE != OFF) foc1.setPhase1();
   if (axis4Settings.reverse == ON) foc1.setReverseState(HIGH);
   foc1.setDisableState(AXIS4_DRIVER_DISABLE);
+  foc1.setAccelProfile(AXIS4_ACCEL_PROFILE,AXIS4_ACCEL_TIME);
+  foc1.initFocusModel(EE_focModelAxis4A,EE_focModelAxis4B);
 
   #if AXIS4_DRIVER_MODEL == TMC_SPI
     tmcAxis4.setup(AXIS4_DRIVER_INTPOL,AXIS4_DRIVER_DECAY_MODE,AXIS4_DRIVER_CODE,axis4Settings.IRUN,axis4Settings.IRUN);
@@ -381,6 +392,8 @@ void setup() {
   if (AXIS5_DRIVER_DC_MODE != OFF) foc2.setPhase2();
   if (axis5Settings.reverse == ON) foc2.setReverseState(HIGH);
   foc2.setDisableState(AXIS5_DRIVER_DISABLE);
+  foc2.setAccelProfile(AXIS5_ACCEL_PROFILE,AXIS5_ACCEL_TIME);
+  foc2.initFocusModel(EE_focModelAxis5A,EE_focModelAxis5B);
 
   #if AXIS5_DRIVER_MODEL == TMC_SPI
     tmcAxis5.setup(AXIS5_DRIVER_INTPOL,AXIS5_DRIVER_DECAY_MODE,AXIS5_DRIVER_CODE,axis5Settings.IRUN,axis5Settings.IRUN);
@@ -416,6 +429,13 @@ void setup() {
 
   // prep counters (for keeping time in main loop)
   cli(); siderealTimer=lst; guideSiderealTimer=lst; pecSiderealTimer=lst; sei();
+
+  // get the task scheduler and profiler ready
+  initTasks();
+#if PROFILER == ON
+  profiler.init();
+#endif
+
   last_loop_micros=micros();
 
   VLF("MSG: OnStep is ready"); VL("");
@@ -427,270 +447,16 @@ void loop() {
 }
 
 void loop2() {
-  // GUIDING -------------------------------------------------------------------------------------------
-  ST4();
-  if ((trackingState != TrackingMoveTo) && (parkStatus == NotParked)) guide();
-
-#if HOME_SENSE != OFF
-  // AUTOMATIC HOMING ----------------------------------------------------------------------------------
-  checkHome();
-#endif
-
-  // 1/100 SECOND TIMED --------------------------------------------------------------------------------
-  cli(); long lstNow=lst; sei();
-  if (lstNow != siderealTimer) {
-    siderealTimer=lstNow;
-
-#ifdef ESP32
-    timerSupervisor(true);
-#endif
-    
-#if AXIS1_PEC == ON
-    // PERIODIC ERROR CORRECTION
-    pec();
-#endif
-
-    // FLASH LED DURING SIDEREAL TRACKING
-#if LED_STATUS == ON
-    if (trackingState == TrackingSidereal) {
-      if (siderealTimer%20L == 0L) { if (ledOn) { digitalWrite(LEDnegPin,HIGH); ledOn=false; } else { digitalWrite(LEDnegPin,LOW); ledOn=true; } }
-    }
-#endif
-
-    // SIDEREAL TRACKING DURING GOTOS
-    // keeps the target where it's supposed to be while doing gotos
-    if (trackingState == TrackingMoveTo) {
-      moveTo();
-      if (lastTrackingState == TrackingSidereal) {
-        origTargetAxis1.fixed+=fstepAxis1.fixed;
-        origTargetAxis2.fixed+=fstepAxis2.fixed;
-        // don't advance the target during meridian flips or sync
-        if (getInstrPierSide() == PierSideEast || getInstrPierSide() == PierSideWest) {
-          cli();
-          targetAxis1.fixed+=fstepAxis1.fixed;
-          targetAxis2.fixed+=fstepAxis2.fixed;
-          sei();
-        }
-      }
-    }
-
-    // ROTATOR/FOCUSERS, MOVE THE TARGET
-#if ROTATOR == ON
-    rot.poll(trackingState == TrackingSidereal);
-#endif
-#if FOCUSER1 == ON
-    foc1.poll();
-#endif
-#if FOCUSER2 == ON
-    foc2.poll();
-#endif
-
-    // CALCULATE SOME TRACKING RATES, ETC.
-    if (lstNow%3 == 0) doFastAltCalc(false);
-#if MOUNT_TYPE == ALTAZM
-    // figure out the current Alt/Azm tracking rates
-    if (lstNow%3 != 0) doHorRateCalc();
-#else
-    // figure out the current refraction compensated tracking rate
-    if (rateCompensation != RC_NONE && lstNow%3 != 0) doRefractionRateCalc();
-#endif
-
-    // SAFETY CHECKS
-#if LIMIT_SENSE != OFF
-    // support for limit switch(es)
-    byte limit_1st = digitalRead(LimitPin);
-    if (limit_1st == LIMIT_SENSE_STATE) {
-      // Wait for a short while, then read again
-      delayMicroseconds(50);
-      byte limit_2nd = digitalRead(LimitPin);
-      if (limit_2nd == LIMIT_SENSE_STATE) {
-        // It is still low, there must be a problem
-        generalError=ERR_LIMIT_SENSE;
-        stopSlewingAndTracking(SS_LIMIT);
-      } 
-    }
-#endif
-
-    // check for fault signal, stop any slew or guide and turn tracking off
-#if AXIS1_DRIVER_STATUS == LOW || AXIS1_DRIVER_STATUS == HIGH
-    faultAxis1=(digitalRead(Axis1_FAULT) == AXIS1_DRIVER_STATUS);
-#elif AXIS1_DRIVER_STATUS == TMC_SPI
-    if (lst%2 == 0) faultAxis1=tmcAxis1.error();
-#endif
-#if AXIS2_DRIVER_STATUS == LOW || AXIS2_DRIVER_STATUS == HIGH
-    faultAxis2=(digitalRead(Axis2_FAULT) == AXIS2_DRIVER_STATUS);
-#elif AXIS2_DRIVER_STATUS == TMC_SPI
-    if (lst%2 == 1) faultAxis2=tmcAxis2.error();
-#endif
-
-    if (faultAxis1 || faultAxis2) { generalError=ERR_MOTOR_FAULT; stopSlewingAndTracking(SS_LIMIT_HARD); }
-
-    if (safetyLimitsOn) {
-      // check altitude overhead limit and horizon limit
-      if (currentAlt < minAlt) { generalError=ERR_ALT_MIN; stopSlewingAndTracking((MOUNT_TYPE == ALTAZM)?SS_LIMIT_AXIS2_MIN:SS_LIMIT); }
-      if (currentAlt > maxAlt) { generalError=ERR_ALT_MAX; stopSlewingAndTracking((MOUNT_TYPE == ALTAZM)?SS_LIMIT_AXIS2_MAX:SS_LIMIT); }
-    }
-
-    // OPTION TO POWER DOWN AXIS2 IF NOT MOVING
-#if AXIS2_DRIVER_POWER_DOWN == ON && MOUNT_TYPE != ALTAZM
-    autoPowerDownAxis2();
-#endif
-
-    // 0.01S POLLING -------------------------------------------------------------------------------------
-#if TIME_LOCATION_SOURCE == GPS
-    if ((PPS_SENSE == OFF || ppsSynced) && tls.poll()) {
-      gpsSynced = true;
-      
-      SerialGPS.end();
-      currentSite=0; 
-      nv.update(EE_currentSite,currentSite);
-      
-
-      tls.getLocation(&latitude, &longitude);
-      tls.get(JD,LMT);
-
-      timeZone=nv.read(EE_sites+currentSite*25+8)-128;
-      timeZone=decodeTimeZone(timeZone);
+  // TASKS ---------------------------------------------------------------------------------------------
+  // guiding, the 1/100 second sidereal tick, tracking rates, commands, housekeeping, etc. see Tasks.ino
+  tasks.poll();
 
-      UT1=LMT+timeZone;
-
-      nv.writeString(EE_sites+currentSite*25+9,(char*)"GPS");
-      setLatitude(latitude);  //Set and STORE latitude
-      nv.writeFloat(EE_sites+currentSite*25+4,longitude);
-      updateLST(jd2last(JD,UT1,false));
-
-      if (generalError == ERR_SITE_INIT) generalError=ERR_NONE;
-
-      dateWasSet=true;
-      timeWasSet=true;
-      VLF("MSG: Successfully got GPS TLS");
-      soundBeep();
-    }
-#endif
-
-    // UPDATE THE UT1 CLOCK
-    cli(); long cs=lst; sei();
-    double t2=(double)((cs-lst_start)/100.0)/1.00273790935;
-    // This just needs to be accurate to the nearest second, it's about 10x better
-    UT1=UT1_start+(t2/3600.0);
-
-    // UPDATE AUXILIARY FEATURES
-#ifdef FEATURES_PRESENT
-    featuresPoll();
-#endif
-    
-    // WEATHER
-    if (!isSlewing()) ambient.poll();
-
-    // MONITOR NV CACHE
-#if DEBUG == VERBOSE && DEBUG_NV == ON
-    static bool lastCommitted=true;
-    bool committed=nv.committed();
-    if (committed && !lastCommitted) { DLF("MSG: NV commit done"); lastCommitted=committed; }
-    if (!committed && lastCommitted) { DLF("MSG: NV data in cache"); lastCommitted=committed; }
-#endif
-
-    // TRIGGER ESPFLASH
-#if defined(AddonTriggerPin)
-    fa.poll();
-#endif
-  }
-
-  // FASTEST POLLING -----------------------------------------------------------------------------------
-#if AXIS1_DRIVER_MODEL == TMC_SPI
-  autoModeSwitch();
-#endif
-
-#if ROTATOR == ON
-  rot.follow(isSlewing());
-#endif
-#if FOCUSER1 == ON
-  foc1.follow(isSlewing());
-#endif
-#if FOCUSER2 == ON
-  foc2.follow(isSlewing());
-#endif
-  if (!isSlewing()) nv.poll();
-  
   // WORKLOAD MONITORING -------------------------------------------------------------------------------
   unsigned long this_loop_micros=micros();
   loop_time=(long)(this_loop_micros-last_loop_micros);
   if (loop_time > worst_loop_time) worst_loop_time=loop_time;
   last_loop_micros=this_loop_micros;
   average_loop_time=(average_loop_time*49+loop_time)/50;
-
-  // 1 SECOND TIMED ------------------------------------------------------------------------------------
-  unsigned long tempMs=millis();
-  static unsigned long housekeepingTimer=0;
-  if ((long)(tempMs-housekeepingTimer) > 1000L) {
-    housekeepingTimer=tempMs;
-
-#if ROTATOR == ON && MOUNT_TYPE == ALTAZM
-    // calculate and set the derotation rate as required
-    double h,d; getApproxEqu(&h,&d,true);
-    if (trackingState == TrackingSidereal) rot.derotate(h,d);
-#endif
-
-    // adjust tracking rate for Alt/Azm mounts
-    // adjust tracking rate for refraction
-    setDeltaTrackingRate();
-
-    // basic check to see if we're not at home
-    if (trackingState != TrackingNone) atHome=false;
-
-#if PPS_SENSE != OFF
-    // update clock via PPS
-    cli();
-    ppsRateRatio=((double)1000000.0/(double)(ppsAvgMicroS));
-    if ((long)(micros()-(ppsLastMicroS+2000000UL)) > 0) ppsSynced=false; // if more than two seconds has ellapsed without a pulse we've lost sync
-    sei();
-  #if LED_STATUS2 == ON
-    if (trackingState == TrackingSidereal) {
-      if (ppsSynced) { if (led2On) { digitalWrite(LEDneg2Pin,HIGH); led2On=false; } else { digitalWrite(LEDneg2Pin,LOW); led2On=true; } } else { digitalWrite(LEDneg2Pin,HIGH); led2On=false; } // indicate PPS
-    }
-  #endif
-    if (ppsLastRateRatio != ppsRateRatio) { SiderealClockSetInterval(siderealInterval); ppsLastRateRatio=ppsRateRatio; }
-#endif
-
-#if LED_STATUS == ON
-    // LED indicate PWR on 
-    if (trackingState != TrackingSidereal) if (!ledOn) { digitalWrite(LEDnegPin,LOW); ledOn=true; }
-#endif
-#if LED_STATUS2 == ON
-    // LED indicate STOP and GOTO
-    if (trackingState == TrackingMoveTo) if (!led2On) { digitalWrite(LEDneg2Pin,LOW); led2On=true; }
-  #if PPS_SENSE != OFF
-    if (trackingState == TrackingNone) if (led2On) { digitalWrite(LEDneg2Pin,HIGH); led2On=false; }
-  #else
-    if (trackingState != TrackingMoveTo) if (led2On) { digitalWrite(LEDneg2Pin,HIGH); led2On=false; }
-  #endif
-#endif
-
-    // SAFETY CHECKS -------------------------------------------------------------------------------------
-    // keeps mount from tracking past the meridian limit, past the AXIS1_LIMIT_MAX, or past the Dec limits
-    if (safetyLimitsOn) {
-      // check for exceeding AXIS1_LIMIT_MIN or AXIS1_LIMIT_MAX
-      if (getInstrAxis1() < axis1Settings.min) { generalError=(MOUNT_TYPE==ALTAZM)?ERR_AZM:ERR_UNDER_POLE; stopSlewingAndTracking(SS_LIMIT_AXIS1_MIN); } else
-      if (getInstrAxis1() > axis1Settings.max) { generalError=(MOUNT_TYPE==ALTAZM)?ERR_AZM:ERR_UNDER_POLE; stopSlewingAndTracking(SS_LIMIT_AXIS1_MAX); } else
-      // check for exceeding Meridian Limits
-      if (meridianFlip != MeridianFlipNever) {
-        if (getInstrPierSide() == PierSideWest) {
-          if (getInstrAxis1() > degreesPastMeridianW && (!(autoMeridianFlip && goToHere(true) == CE_NONE))) { generalError=ERR_MERIDIAN; stopSlewingAndTracking(SS_LIMIT_AXIS1_MAX); }
-        } else
-        if (getInstrAxis1() < -degreesPastMeridianE) { generalError=ERR_MERIDIAN; stopSlewingAndTracking(SS_LIMIT_AXIS1_MIN); }
-      }
-    }
-    double a2; if (AXIS2_TANGENT_ARM == ON) { cli(); a2=posAxis2/axis2Settings.stepsPerMeasure; sei(); } else a2=getInstrAxis2();
-    // check for exceeding AXIS2_LIMIT_MIN or AXIS2_LIMIT_MAX
-    if (a2 < axis2Settings.min) { generalError=ERR_DEC; stopSlewingAndTracking(SS_LIMIT_AXIS2_MIN); } else
-    if (a2 > axis2Settings.max) { generalError=ERR_DEC; stopSlewingAndTracking(SS_LIMIT_AXIS2_MAX); } else
-    // automatically clear error in TA mode
-    if (AXIS2_TANGENT_ARM == ON && (trackingState == TrackingSidereal && generalError == ERR_DEC)) generalError=ERR_NONE;
-
-  } else {
-    // COMMAND PROCESSING --------------------------------------------------------------------------------
-    processCommands();
-  }
 }
 
 // stops fast motion as required
@@ -11,13 +11,12 @@ long guideSiderealTimer                 = 0;                 // counter to issue
 bool dateWasSet                         = false;             // keep track of date/time validity
 bool timeWasSet                         = false;                          
                                                                           
-double UT1                              = 0.0;               // the current universal time
-double UT1_start                        = 0.0;               // the start of UT1
+double UT1                              = 0.0;               // the current universal time, 0 to 24 hours
+long UT1_days                           = 0;                 // whole days UT1 is past 0h of the JD date
 double JD                               = 0.0;               // and date, used for computing LST
 double LMT                              = 0.0;
 double timeZone                         = 0.0;
                                                                           
-long lst_start                          = 0;                 // marks the start lst when UT1 is set 
 volatile long lst                       = 0;                 // local (apparent) sidereal time in 0.01 second ticks,
                                                              // takes 249 days to roll over.
                                                              // 1.00273 wall clock seconds per sidereal second
@@ -42,7 +41,11 @@ long average_loop_time                  = 0;
 
 // PPS (GPS) -----------------------------------------------------------------------------------------------------------------------
 volatile unsigned long ppsLastMicroS    = 1000000UL;
-volatile unsigned long ppsAvgMicroS     = 1000000UL;
+volatile unsigned long ppsIntervalMicroS = 1000000UL;            // last PPS interval in micros()
+volatile unsigned long ppsSamples        = 0;                    // count of PPS intervals measured
+volatile unsigned long lstMicroS         = 0;                    // micros() at the last sidereal clock centi-second
+volatile long ppsLst                     = 0;                    // sidereal clock phase at the last PPS edge, centi-seconds
+volatile unsigned long ppsLstMicroS      = 0;                    //   plus micros() past that centi-second
 volatile double ppsRateRatio            = 1.0;
 volatile double ppsLastRateRatio        = 1.0;
 volatile bool ppsSynced              = false;
@@ -110,6 +113,16 @@ axisSettingsEx axis3SettingsEx          = {AXIS3_DRIVER_IHOLD, OFF};
 axisSettingsEx axis4SettingsEx          = {AXIS4_DRIVER_IHOLD, OFF};
 axisSettingsEx axis5SettingsEx          = {AXIS5_DRIVER_IHOLD, OFF};
 
+#if GUIDE_CONTROL == ON
+// closed loop guide controller state for one axis
+typedef struct GuideControlAxis {
+  double error;                                              // estimated error in arc-seconds, + to move the axis in the + direction
+  double integral;                                           // integral of the error in arc-second seconds
+  double lastError;
+  double rate;                                               // correction rate in x sidereal
+} guideControlAxis;
+#endif
+
 unsigned long axis1StepsGoto            = 1;
 unsigned long axis2StepsGoto            = 1;
 
@@ -125,6 +138,7 @@ volatile bool useTimerRateRatio;
 long stepsPerWormRotationAxis1;
 long secondsPerWormRotationAxis1;
 long maxRate;
+long gotoRateScale = 256;                                    // GOTO_RATE_ADAPTIVE fastest goto rate as a multiple of maxRate, in 1/256ths
 #define maxRateBaseDesired                ((1000000.0/(SLEW_RATE_BASE_DESIRED))/axis1Settings.stepsPerMeasure)
 double maxRateBaseActual;
 volatile double stepsForRateChangeAxis1;
@@ -385,6 +399,13 @@ volatile byte guideDirAxis2             = 0;
 char          ST4DirAxis2               = 'b';
 int           spiralGuide               = 0;
 
+// search pattern used by spiral guides (:Mp#), spacing between passes is the FOV less the overlap
+enum SearchPattern {SP_ARCHIMEDEAN, SP_SQUARE, SP_RASTER};
+SearchPattern searchPattern             = SP_ARCHIMEDEAN;
+double        searchFov                 = GUIDE_SEARCH_FOV;     // in arc-seconds, 0 for two seconds of travel at the guide rate
+double        searchOverlap             = GUIDE_SEARCH_OVERLAP; // fraction of the FOV, 0.0 to 0.5
+int           searchRasterRows          = GUIDE_SEARCH_ROWS;    // rows (and columns) covered by a raster search
+
 volatile double guideTimerRateAxis1     = 0.0;
 volatile double guideTimerRateAxis2     = 0.0;
 volatile double guideTimerBaseRateAxis1 = 0.0;
@@ -389,6 +389,11 @@ CommandErrors goTo(double thisTargetAxis1, double thisTargetAxis2, double altTar
   timerRateAxis2=siderealRate;
   sei();
 
+  gotoRateScale=256;
+#if AXIS1_DRIVER_STATUS == TMC_SPI && AXIS2_DRIVER_STATUS == TMC_SPI
+  loadReset();
+#endif
+
   setTargetAxis1(thisTargetAxis1,p);
   setTargetAxis2(thisTargetAxis2,p);
 
@@ -409,3 +414,12 @@ CommandErrors goTo(double thisTargetAxis1, double thisTargetAxis2, double altTar
   VLF("MSG: Goto started");
   return CE_NONE;
 }
+
+// fastest rate for the current goto, GOTO_RATE_ADAPTIVE scales the live maxRate so slew rate changes still take effect
+long gotoRate() {
+#if GOTO_RATE_ADAPTIVE == ON
+  return (maxRate*gotoRateScale)/256L;
+#else
+  return maxRate;
+#endif
+}
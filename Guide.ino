@@ -27,7 +27,6 @@ button st4w;
 
 #endif
 
-unsigned long guideStartTime             = 0;
 long          guideTimeRemainingAxis1    = -1;
 unsigned long guideTimeThisIntervalAxis1 = -1;
 long          guideTimeRemainingAxis2    = -1;
@@ -35,6 +34,24 @@ unsigned long guideTimeThisIntervalAxis2 = -1;
 double        guideTimerCustomRateAxis1  = 0.0;
 double        guideTimerCustomRateAxis2  = 0.0;
 
+// pulse guides below 10x are timed by the sidereal timer supervisor, exact time at rate in uS or -1 if not active
+volatile long guidePulseRemainingAxis1   = -1;
+volatile long guidePulseRemainingAxis2   = -1;
+// and how far they've moved since guide() last looked, in 1/100 seconds at guide rate (+ is west)
+volatile double guidePulseMovedAxis1     = 0.0;
+
+// true while a guide runs at a rate other than the selected guide rate (offsets,) amountGuideAxis1/2 is restored after
+bool          guideRateOtherAxis1        = false;
+bool          guideRateOtherAxis2        = false;
+
+// pulse guides that arrive while one is running on the same axis are merged into a pending pulse
+char          guidePulseQueueDirAxis1    = 0;
+long          guidePulseQueueTimeAxis1   = 0;
+int           guidePulseQueueRateAxis1   = 0;
+char          guidePulseQueueDirAxis2    = 0;
+long          guidePulseQueueTimeAxis2   = 0;
+int           guidePulseQueueRateAxis2   = 0;
+
 // initialize guiding
 void initGuide() {
   guideDirAxis1              =  0;
@@ -43,6 +60,11 @@ void initGuide() {
   guideDirAxis2              =  0;
   guideTimeRemainingAxis2    = -1;
   guideTimeThisIntervalAxis2 = -1;
+  guidePulseRemainingAxis1   = -1;
+  guidePulseRemainingAxis2   = -1;
+  guidePulseMovedAxis1       = 0.0;
+  guidePulseQueueDirAxis1    =  0;
+  guidePulseQueueDirAxis2    =  0;
 
 #if ST4_INTERFACE == ON || ST4_INTERFACE == ON_PULLUP
   #if ST4_INTERFACE == ON
@@ -63,10 +85,21 @@ void guide() {
   cli(); long guideLst=lst; sei();
   if (guideLst != guideSiderealTimer) {
     guideSiderealTimer=guideLst;  
+
+    // guideAxis1 keeps track of how many steps we've moved for PEC recording
+    // pulse guides timed by the timer supervisor count what they really moved, including a partial last period
+    cli(); bool idleAxis1=!guideDirAxis1; bool idleAxis2=!guideDirAxis2; double moved=guidePulseMovedAxis1; guidePulseMovedAxis1=0.0; sei();
+    if (moved != 0.0) guideAxis1.fixed=doubleToFixed(fixedToDouble(amountGuideAxis1)*moved);
+
+    // once a guide at another rate is done the amounts go back to the selected guide rate
+    if (idleAxis1 && guideRateOtherAxis1) { guideRateOtherAxis1=false; amountGuideAxis1.fixed=doubleToFixed((guideTimerBaseRateAxis1*stepsPerSecondAxis1)/100.0); }
+    if (idleAxis2 && guideRateOtherAxis2) { guideRateOtherAxis2=false; amountGuideAxis2.fixed=doubleToFixed((guideTimerBaseRateAxis2*stepsPerSecondAxis2)/100.0); }
+
     if (guideDirAxis1) {
       if (!inbacklashAxis1) {
-        // guideAxis1 keeps track of how many steps we've moved for PEC recording
-        if (guideDirAxis1 == 'e') guideAxis1.fixed=-amountGuideAxis1.fixed; else if (guideDirAxis1 == 'w') guideAxis1.fixed=amountGuideAxis1.fixed;
+        if (guidePulseRemainingAxis1 < 0) {
+          if (guideDirAxis1 == 'e') guideAxis1.fixed=-amountGuideAxis1.fixed; else if (guideDirAxis1 == 'w') guideAxis1.fixed=amountGuideAxis1.fixed;
+        }
 
         // for pulse guiding, count down the mS and stop when timed out
         if (guideTimeRemainingAxis1 > 0) {
@@ -98,9 +131,91 @@ void guide() {
     if (spiralGuide) {
       if ((guideDirAxis1 == 'e' || guideDirAxis1 == 'w') && (guideDirAxis2 == 'n' || guideDirAxis2 == 's')) guideSpiralPoll(); else stopGuideSpiral();
     }
+
+#if GUIDE_CONTROL == ON
+    // closed loop guide corrections
+    guideControlPoll();
+#endif
+  }
+
+  // start any pending pulse guides once the axis is free, they wait while the mount is busy and are dropped if refused otherwise
+  if (guidePulseQueueDirAxis1 && !guideDirAxis1) {
+    char d=guidePulseQueueDirAxis1; guidePulseQueueDirAxis1=0;
+    CommandErrors e=startGuideAxis1(d,guidePulseQueueRateAxis1,guidePulseQueueTimeAxis1,true);
+    if (e == CE_MOUNT_IN_MOTION) guidePulseQueueDirAxis1=d; else
+    if (e != CE_NONE) DLF("WRN, guide(): queued Axis1 pulse guide dropped");
+  }
+  if (guidePulseQueueDirAxis2 && !guideDirAxis2) {
+    char d=guidePulseQueueDirAxis2; guidePulseQueueDirAxis2=0;
+    CommandErrors e=startGuideAxis2(d,guidePulseQueueRateAxis2,guidePulseQueueTimeAxis2,true);
+    if (e == CE_MOUNT_IN_MOTION) guidePulseQueueDirAxis2=d; else
+    if (e != CE_NONE) DLF("WRN, guide(): queued Axis2 pulse guide dropped");
   }
 }
 
+// merge a pulse guide into the pending pulse, opposite directions cancel
+void queuePulse(char *queueDir, long *queueTime, int *queueRate, char direction, int guideRate, long guideDuration) {
+  if (*queueDir == 0) { *queueDir=direction; *queueTime=guideDuration; } else
+  if (*queueDir == direction) *queueTime+=guideDuration; else {
+    *queueTime-=guideDuration;
+    if (*queueTime < 0) { *queueTime=-*queueTime; *queueDir=direction; }
+    if (*queueTime == 0) *queueDir=0;
+  }
+  if (*queueTime > GUIDE_PULSE_QUEUE_LIMIT) *queueTime=GUIDE_PULSE_QUEUE_LIMIT;
+  *queueRate=guideRate;
+}
+
+// pulse guide in RA or Azm, queued if a pulse guide is already running on this axis, guideDuration is in ms
+CommandErrors pulseGuideAxis1(char direction, int guideRate, long guideDuration) {
+  if (guideDirAxis1 == 0) return startGuideAxis1(direction,guideRate,guideDuration,true);
+  if (!lastGuidePulseGuideAxis1 || isSpiralGuiding()) return CE_MOUNT_IN_MOTION;
+  queuePulse(&guidePulseQueueDirAxis1,&guidePulseQueueTimeAxis1,&guidePulseQueueRateAxis1,direction,guideRate,guideDuration);
+  return CE_NONE;
+}
+
+// pulse guide in Dec or Alt, queued if a pulse guide is already running on this axis, guideDuration is in ms
+CommandErrors pulseGuideAxis2(char direction, int guideRate, long guideDuration) {
+  if (guideDirAxis2 == 0) return startGuideAxis2(direction,guideRate,guideDuration,true);
+  if (!lastGuidePulseGuideAxis2 || isSpiralGuiding()) return CE_MOUNT_IN_MOTION;
+  queuePulse(&guidePulseQueueDirAxis2,&guidePulseQueueTimeAxis2,&guidePulseQueueRateAxis2,direction,guideRate,guideDuration);
+  return CE_NONE;
+}
+
+// rate (x sidereal) to move an offset that takes t seconds at 1x, shaped to finish within GUIDE_OFFSET_TIME_LIMIT ms
+double guideOffsetRate(double t) {
+  double rate=t/(GUIDE_OFFSET_TIME_LIMIT/1000.0);
+  if (rate < GUIDE_OFFSET_RATE_MIN) rate=GUIDE_OFFSET_RATE_MIN;
+  return rate;
+}
+
+// largest offset in steps that can be moved within GUIDE_OFFSET_TIME_LIMIT ms at GUIDE_OFFSET_RATE_MAX
+double guideOffsetMaxAxis1() { return GUIDE_OFFSET_RATE_MAX*stepsPerSecondAxis1*(GUIDE_OFFSET_TIME_LIMIT/1000.0); }
+double guideOffsetMaxAxis2() { return GUIDE_OFFSET_RATE_MAX*stepsPerSecondAxis2*(GUIDE_OFFSET_TIME_LIMIT/1000.0); }
+
+// guide offset in RA or Azm, steps is signed (+ is west) and may include a fractional part
+CommandErrors guideOffsetAxis1(double steps) {
+  if (guideDirAxis1) return CE_MOUNT_IN_MOTION;
+  if (steps == 0.0) return CE_NONE;
+  if (fabs(steps) > guideOffsetMaxAxis1()) return CE_PARAM_RANGE;
+
+  double rate=guideOffsetRate(fabs(steps)/stepsPerSecondAxis1);
+  long t=lround((fabs(steps)/(rate*stepsPerSecondAxis1))*1000000.0); if (t < 1) t=1;
+
+  return startGuideAxis1(steps < 0 ? 'e':'w',GuideRate1x,rate,t,true);
+}
+
+// guide offset in Dec or Alt, steps is signed (+ is north) and may include a fractional part
+CommandErrors guideOffsetAxis2(double steps) {
+  if (guideDirAxis2) return CE_MOUNT_IN_MOTION;
+  if (steps == 0.0) return CE_NONE;
+  if (fabs(steps) > guideOffsetMaxAxis2()) return CE_PARAM_RANGE;
+
+  double rate=guideOffsetRate(fabs(steps)/stepsPerSecondAxis2);
+  long t=lround((fabs(steps)/(rate*stepsPerSecondAxis2))*1000000.0); if (t < 1) t=1;
+
+  return startGuideAxis2(steps < 0 ? 's':'n',GuideRate1x,rate,t,true,false);
+}
+
 // returns true if a spiral guide is happening
 bool lastGuideSpiralGuide = false;
 bool isSpiralGuiding() {
@@ -142,6 +257,11 @@ void deactivateBacklashComp() {
 
 // start a guide in RA or Azm, direction must be 'e', 'w', or 'b', guideRate is the rate selection (0 to 9), guideDuration is in ms (0 to ignore) 
 CommandErrors startGuideAxis1(char direction, int guideRate, long guideDuration, bool pulseGuide) {
+  return startGuideAxis1(direction,guideRate,0.0,guideDuration*1000L,pulseGuide);
+}
+
+// as above, but moves at rate (x sidereal) instead of the rate selection's unless 0.0, guideMicros is in uS (0 to ignore)
+CommandErrors startGuideAxis1(char direction, int guideRate, double rate, long guideMicros, bool pulseGuide) {
   // Check state
   if (faultAxis1)                         return CE_SLEW_ERR_HARDWARE_FAULT;
   if (!axis1Enabled)                      return CE_SLEW_ERR_IN_STANDBY;
@@ -162,11 +282,24 @@ CommandErrors startGuideAxis1(char direction, int guideRate, long guideDuration,
   
   if (guideRate < 3) deactivateBacklashComp(); else reactivateBacklashComp();
   enableGuideRate(guideRate);
-  guideDirAxis1=direction;
+  bool other=(rate != 0.0);
+  if (!other) rate=guideTimerBaseRateAxis1;
+  fixed_t amount; amount.fixed=doubleToFixed((rate*stepsPerSecondAxis1)/100.0);
   guideTimeThisIntervalAxis1=micros();
-  guideTimeRemainingAxis1=guideDuration*1000L;
+  // the rate, time, amount, and direction all change together so the timer supervisor never runs a period with part of them
   cli();
-  if (guideDirAxis1 == 'e') guideTimerRateAxis1=-guideTimerBaseRateAxis1; else guideTimerRateAxis1=guideTimerBaseRateAxis1; 
+  // slow pulse guides are timed exactly by the timer supervisor, others are counted down here
+  if (pulseGuide && guideMicros > 0 && fabs(rate) < 10.0) {
+    guidePulseRemainingAxis1=guideMicros;
+    guideTimeRemainingAxis1=-1;
+  } else {
+    guidePulseRemainingAxis1=-1;
+    guideTimeRemainingAxis1=guideMicros;
+  }
+  if (direction == 'e') guideTimerRateAxis1=-rate; else guideTimerRateAxis1=rate;
+  amountGuideAxis1.fixed=amount.fixed;
+  guideRateOtherAxis1=other;
+  guideDirAxis1=direction;
   sei();
   lastGuidePulseGuideAxis1 = pulseGuide;
   
@@ -175,11 +308,17 @@ CommandErrors startGuideAxis1(char direction, int guideRate, long guideDuration,
 
 // stops guide in RA or Azm
 void stopGuideAxis1() {
+  guidePulseQueueDirAxis1=0;
   cli(); if (guideDirAxis1 && guideDirAxis1 != 'b') { guideDirAxis1='b'; } sei();
 }
 
 // start a guide in Dec or Alt, direction must be 'n', 's', or 'b', guideRate is the rate selection (0 to 9), guideDuration is in ms (0 to ignore) 
 CommandErrors startGuideAxis2(char direction, int guideRate, long guideDuration, bool pulseGuide, bool absolute) {
+  return startGuideAxis2(direction,guideRate,0.0,guideDuration*1000L,pulseGuide,absolute);
+}
+
+// as above, but moves at rate (x sidereal) instead of the rate selection's unless 0.0, guideMicros is in uS (0 to ignore)
+CommandErrors startGuideAxis2(char direction, int guideRate, double rate, long guideMicros, bool pulseGuide, bool absolute) {
   if (faultAxis2)                          return CE_SLEW_ERR_HARDWARE_FAULT;
   if (!axis1Enabled)                       return CE_SLEW_ERR_IN_STANDBY;
   if (parkStatus == Parked)                return CE_SLEW_ERR_IN_PARK;
@@ -199,12 +338,25 @@ CommandErrors startGuideAxis2(char direction, int guideRate, long guideDuration,
 
   enableGuideRate(guideRate);
   if (guideRate < 3) deactivateBacklashComp(); else reactivateBacklashComp();
-  guideDirAxis2=direction;
+  bool other=(rate != 0.0);
+  if (!other) rate=guideTimerBaseRateAxis2;
+  fixed_t amount; amount.fixed=doubleToFixed((rate*stepsPerSecondAxis2)/100.0);
+  double r=rate; if (direction == 's') r=-rate;
+  if (!absolute && (getInstrPierSide() == PierSideWest)) r=-r;
   guideTimeThisIntervalAxis2=micros();
-  guideTimeRemainingAxis2=guideDuration*1000L;
-  if (guideDirAxis2 == 's') { cli(); guideTimerRateAxis2=-guideTimerBaseRateAxis2; sei(); } 
-  if (guideDirAxis2 == 'n') { cli(); guideTimerRateAxis2= guideTimerBaseRateAxis2; sei(); }
-  if (!absolute && (getInstrPierSide() == PierSideWest)) { cli(); guideTimerRateAxis2=-guideTimerRateAxis2; sei(); }
+  cli();
+  if (pulseGuide && guideMicros > 0 && fabs(rate) < 10.0) {
+    guidePulseRemainingAxis2=guideMicros;
+    guideTimeRemainingAxis2=-1;
+  } else {
+    guidePulseRemainingAxis2=-1;
+    guideTimeRemainingAxis2=guideMicros;
+  }
+  if (direction == 'n' || direction == 's') guideTimerRateAxis2=r;
+  amountGuideAxis2.fixed=amount.fixed;
+  guideRateOtherAxis2=other;
+  guideDirAxis2=direction;
+  sei();
   lastGuidePulseGuideAxis2 = pulseGuide;
   
   return CE_NONE;
@@ -245,6 +397,7 @@ CommandErrors startGuideAxis2(char direction, int guideRate, long guideDuration,
 
 // stops guide in Dec or Alt
 void stopGuideAxis2() {
+  guidePulseQueueDirAxis2=0;
   cli(); if (guideDirAxis2 && guideDirAxis2 != 'b') { guideDirAxis2='b'; } sei();
 }
 
@@ -272,7 +425,6 @@ CommandErrors startGuideSpiral(int guideRate, long guideDuration) {
   if (spiralGuide < 3) spiralGuide=3;
   if (spiralGuide > 8) spiralGuide=8;
 
-  guideStartTime=millis();
   guideTimeThisIntervalAxis1=micros();
   guideTimeRemainingAxis1=guideDuration*1000L;
   guideTimeThisIntervalAxis2=micros();
@@ -281,6 +433,7 @@ CommandErrors startGuideSpiral(int guideRate, long guideDuration) {
   spiralScaleAxis1=cos(getInstrAxis2()/Rad);
 
   lastGuideSpiralGuide=true;
+  guideSpiralInit();
   guideSpiralPoll();
 
   return CE_NONE;
@@ -295,31 +448,96 @@ void stopGuideSpiral() {
   sei();
 }
 
-// set guide spiral rates in RA/Azm and Dec/Alt, rate is in x-sidereal, guideElapsed time is in ms 
-void guideSpiralPoll() {
-  // current elapsed time in seconds
-  double T=((long)(millis()-guideStartTime))/1000.0;
-
-  // actual rate we'll be using (in arc-seconds per second)
-  double rate=guideRates[spiralGuide];
-  if (rate > 1800.0) rate=1800.0;
-
-  // apparaent FOV (in arc-seconds)
-  // double fov=rate*2.0;
+// search pattern state, x is along Axis1 and y along Axis2 (in arc-seconds on the sky)
+double searchSpeed        = 0;                               // arc-seconds per second
+double searchSpacing      = 0;                               // arc-seconds between passes
+double searchTheta        = 0;                               // Archimedean spiral angle in radians
+double searchCos          = 1.0;                             // cos/sin of searchTheta, advanced by rotation
+double searchSin          = 0.0;
+double searchDirX         = 1.0;                             // square spiral/raster unit direction
+double searchDirY         = 0.0;
+double searchLegRemaining = 0;                               // arc-seconds left in this square spiral/raster leg
+int    searchLeg          = 0;
+long   searchLastLst      = 0;
+
+// start a new leg of a square spiral or raster, returns false when the pattern is complete
+bool searchNextLeg() {
+  searchLeg++;
+  if (searchPattern == SP_SQUARE) {
+    // turn 90 degrees counter-clockwise, legs are 1,1,2,2,3,3... spacings long
+    double x=searchDirX; searchDirX=-searchDirY; searchDirY=x;
+    searchLegRemaining+=searchSpacing*(searchLeg/2+1);
+  } else {
+    // from the center go to the lower left corner then back and forth across the rows working upward
+    double size=searchSpacing*(searchRasterRows-1);
+    if (searchLeg == 1) { searchDirX=0.0; searchDirY=-1.0; searchLegRemaining+=size/2.0; } else {
+      int k=searchLeg-2;
+      if (k/2 >= searchRasterRows) return false;
+      if (k%2 == 0) { searchDirX=((k/2)%2 == 0) ? 1.0:-1.0; searchDirY=0.0; searchLegRemaining+=size; } else {
+        if (k/2 >= searchRasterRows-1) return false;
+        searchDirX=0.0; searchDirY=1.0; searchLegRemaining+=searchSpacing;
+      }
+    }
+  }
+  return true;
+}
 
-  // current radius assuming movement at 2 seconds per fov
-  double radius=pow(T/6.28318,1.0/1.74);
+// initialize the search pattern for a spiral guide
+void guideSpiralInit() {
+  searchSpeed=guideRates[spiralGuide];
+  if (searchSpeed > 1800.0) searchSpeed=1800.0;
+  double fov=searchFov; if (fov <= 0.0) fov=searchSpeed*2.0;
+  searchSpacing=fov*(1.0-searchOverlap);
+
+  searchTheta=0.0; searchCos=1.0; searchSin=0.0;
+  searchLeg=0;
+  if (searchPattern == SP_SQUARE) { searchDirX=1.0; searchDirY=0.0; searchLegRemaining=searchSpacing; } else
+  if (searchPattern == SP_RASTER) { searchDirX=-1.0; searchDirY=0.0; searchLegRemaining=searchSpacing*(searchRasterRows-1)/2.0; }
+  cli(); searchLastLst=lst; sei();
+}
 
-  // current angle in radians
-  double angle =(radius-trunc(radius))*6.28318;
+// set guide spiral rates in RA/Azm and Dec/Alt for the search pattern, called once every 1/100 second
+void guideSpiralPoll() {
+  // time since the last poll in seconds
+  cli(); long lstNow=lst; sei();
+  double dt=(lstNow-searchLastLst)/100.0;
+  searchLastLst=lstNow;
+
+  // direction of travel for the next interval
+  double vx, vy;
+  if (searchPattern == SP_ARCHIMEDEAN) {
+    // r=k*theta so a pass is searchSpacing from the last, the path tangent is k*(cos,sin)+r*(-sin,cos)
+    double k=searchSpacing/6.28318;
+    double r=k*searchTheta;
+    double len=sqrt(k*k+r*r);
+    vx=(k*searchCos-r*searchSin)/len;
+    vy=(k*searchSin+r*searchCos)/len;
+
+    // advance the angle for constant speed along the path with a rotation recurrence, small angle sin/cos are exact enough here
+    double d=searchSpeed*dt/len; if (d > 0.25) d=0.25;
+    double cd=1.0-d*d/2.0;
+    double sd=d-d*d*d/6.0;
+    double c=searchCos*cd-searchSin*sd;
+    double si=searchSin*cd+searchCos*sd;
+    // keep the cos/sin pair on the unit circle
+    double n=(3.0-(c*c+si*si))/2.0;
+    searchCos=c*n; searchSin=si*n;
+    searchTheta+=d;
+  } else {
+    searchLegRemaining-=searchSpeed*dt;
+    while (searchLegRemaining <= 0.0) { if (!searchNextLeg()) { stopGuideSpiral(); return; } }
+    vx=searchDirX; vy=searchDirY;
+  }
 
-  // calculate the Axis rates for this moment
-  guideTimerCustomRateAxis1=(rate/15.0)*cos(angle);
-  guideTimerCustomRateAxis2=(rate/15.0)*sin(angle);
+  // calculate the Axis rates for this moment, a zero custom rate would select a standard rate so keep them just above zero
+  guideTimerCustomRateAxis1=(searchSpeed/15.0)*vx;
+  guideTimerCustomRateAxis2=(searchSpeed/15.0)*vy;
 
   // set direction
   if (guideTimerCustomRateAxis1 < 0) { guideTimerCustomRateAxis1=fabs(guideTimerCustomRateAxis1); guideDirAxis1='e'; } else guideDirAxis1='w';
   if (guideTimerCustomRateAxis2 < 0) { guideTimerCustomRateAxis2=fabs(guideTimerCustomRateAxis2); guideDirAxis2='s'; } else guideDirAxis2='n';
+  if (guideTimerCustomRateAxis1 < 0.000001) guideTimerCustomRateAxis1=0.000001;
+  if (guideTimerCustomRateAxis2 < 0.000001) guideTimerCustomRateAxis2=0.000001;
 
   // adjust Axis1 due to spherical coordinates
   guideTimerCustomRateAxis1/=spiralScaleAxis1;
@@ -404,8 +622,9 @@ void enableGuideRate(int g) {
   } else {
     guideTimerBaseRateAxis2=(double)(guideRates[g]/15.0);
   }
-  amountGuideAxis1.fixed=doubleToFixed((guideTimerBaseRateAxis1*stepsPerSecondAxis1)/100.0);
-  amountGuideAxis2.fixed=doubleToFixed((guideTimerBaseRateAxis2*stepsPerSecondAxis2)/100.0);
+  // a guide running at another rate keeps its amount until it's done
+  if (!guideRateOtherAxis1) amountGuideAxis1.fixed=doubleToFixed((guideTimerBaseRateAxis1*stepsPerSecondAxis1)/100.0);
+  if (!guideRateOtherAxis2) amountGuideAxis2.fixed=doubleToFixed((guideTimerBaseRateAxis2*stepsPerSecondAxis2)/100.0);
 }
 
 // handle the ST4 interface and hand controller features
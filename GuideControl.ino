@@ -0,0 +1,111 @@
+// -----------------------------------------------------------------------------------
+// Guide control, closed loop guiding from centroid errors run at the guide() tick rate
+
+#if GUIDE_CONTROL == ON
+
+// calibration matrix in arc-seconds per pixel, axis1=m[0]*dx+m[1]*dy and axis2=m[2]*dx+m[3]*dy
+double guideControlMatrix[4]       = {1.0, 0.0, 0.0, 1.0};
+double guideControlKp              = GUIDE_CONTROL_KP;
+double guideControlKi              = GUIDE_CONTROL_KI;
+double guideControlKd              = GUIDE_CONTROL_KD;
+double guideControlKe              = GUIDE_CONTROL_KE;       // estimator gain, 1.0 takes each measurement as is
+bool   guideControlEnabled         = false;
+long   guideControlMeasurements    = 0;
+guideControlAxis guideControlAxis1 = {0.0, 0.0, 0.0, 0.0};
+guideControlAxis guideControlAxis2 = {0.0, 0.0, 0.0, 0.0};
+
+// correction rates in x sidereal, summed with the guide, PEC, and tracking rates in timerSupervisor()
+volatile double guideControlRateAxis1 = 0.0;
+volatile double guideControlRateAxis2 = 0.0;
+
+void guideControlReset() {
+  guideControlAxis1.error=0.0; guideControlAxis1.integral=0.0; guideControlAxis1.lastError=0.0; guideControlAxis1.rate=0.0;
+  guideControlAxis2.error=0.0; guideControlAxis2.integral=0.0; guideControlAxis2.lastError=0.0; guideControlAxis2.rate=0.0;
+  cli(); guideControlRateAxis1=0.0; guideControlRateAxis2=0.0; sei();
+}
+
+void guideControlStart() {
+  guideControlReset();
+  guideControlMeasurements=0;
+  guideControlEnabled=true;
+}
+
+void guideControlStop() {
+  guideControlEnabled=false;
+  guideControlReset();
+}
+
+void guideControlSetMatrix(double m0, double m1, double m2, double m3) {
+  guideControlMatrix[0]=m0; guideControlMatrix[1]=m1; guideControlMatrix[2]=m2; guideControlMatrix[3]=m3;
+}
+
+bool guideControlSetGains(double kp, double ki, double kd, double ke) {
+  if (kp < 0.0 || ki < 0.0 || kd < 0.0 || ke <= 0.0 || ke > 1.0) return false;
+  guideControlKp=kp; guideControlKi=ki; guideControlKd=kd; guideControlKe=ke;
+  guideControlAxis1.integral=0.0; guideControlAxis2.integral=0.0;
+  return true;
+}
+
+// a new centroid error in pixels, corrects the estimated error on both axes
+bool guideControlMeasurement(double dx, double dy) {
+  if (!guideControlEnabled) return false;
+  double e1=guideControlMatrix[0]*dx+guideControlMatrix[1]*dy;
+  double e2=guideControlMatrix[2]*dx+guideControlMatrix[3]*dy;
+  guideControlAxis1.error+=guideControlKe*(e1-guideControlAxis1.error);
+  guideControlAxis2.error+=guideControlKe*(e2-guideControlAxis2.error);
+  guideControlMeasurements++;
+  return true;
+}
+
+// one PID step on the estimated error, returns the correction rate in x sidereal
+double guideControlUpdate(guideControlAxis *a) {
+  const double dt=0.01;
+  const double rateMax=GUIDE_CONTROL_RATE_MAX*15.0;
+
+  a->integral+=a->error*dt;
+  if (guideControlKi > 0.0) {
+    if (guideControlKi*a->integral >  rateMax) a->integral= rateMax/guideControlKi;
+    if (guideControlKi*a->integral < -rateMax) a->integral=-rateMax/guideControlKi;
+  }
+  double u=guideControlKp*a->error+guideControlKi*a->integral+guideControlKd*(a->error-a->lastError)/dt;
+  a->lastError=a->error;
+  if (u >  rateMax) u= rateMax;
+  if (u < -rateMax) u=-rateMax;
+
+  // predict, the correction applied over this tick removes u*dt arc-seconds of error
+  // tracking and PEC are already in the motor rates so they act as feed-forward and aren't part of the prediction
+  a->error-=u*dt;
+  a->rate=u/15.0;
+  return a->rate;
+}
+
+// called once every 1/100 second from guide()
+void guideControlPoll() {
+  if (!guideControlEnabled) return;
+
+  // hold while not sidereal tracking or while any other guide is running
+  if (trackingState != TrackingSidereal || guideDirAxis1 || guideDirAxis2 || guideControlMeasurements == 0) {
+    if (guideControlRateAxis1 != 0.0 || guideControlRateAxis2 != 0.0) guideControlReset();
+    return;
+  }
+
+  double r1=guideControlUpdate(&guideControlAxis1);
+  double r2=guideControlUpdate(&guideControlAxis2);
+  if (getInstrPierSide() == PierSideWest) r2=-r2;
+  cli(); guideControlRateAxis1=r1; guideControlRateAxis2=r2; sei();
+
+  // guideAxis1 keeps track of how many steps we've moved for PEC recording
+  guideAxis1.fixed+=doubleToFixed((r1*stepsPerSecondAxis1)/100.0);
+}
+
+// status as "e,n,e1,e2,r1,r2" where e is enabled (0 or 1), n is the number of measurements, e1/e2 are the estimated errors in arc-seconds and r1/r2 the correction rates in x sidereal
+void guideControlStatus(char *reply) {
+  char s1[12], s2[12], s3[12], s4[12];
+  dtostrf(guideControlAxis1.error,1,2,s1);
+  dtostrf(guideControlAxis2.error,1,2,s2);
+  dtostrf(guideControlAxis1.rate,1,4,s3);
+  dtostrf(guideControlAxis2.rate,1,4,s4);
+  sprintf(reply,"%d,%ld,%s,%s,%s,%s",(int)guideControlEnabled,guideControlMeasurements,s1,s2,s3,s4);
+}
+
+#endif
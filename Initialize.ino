@@ -182,9 +182,27 @@ void initWriteNvValues() {
   // EEPROM automatic initialization
   if (NV_FACTORY_RESET == ON) nv.writeLong(EE_autoInitKey,0);
 
+  if (nv.readLong(EE_autoInitKey) == NV_INIT_KEY_PREV) {
+    // migrate from the previous format, the library gave up its last records to general purpose storage C and D
+    long byteMin=200+pecBufferSize;
+    long byteCount=(long)GSB-byteMin;
+    if (byteCount < 0) byteCount=0;
+    if (byteCount > 262143) byteCount=262143;
+    long recMaxPrev=byteCount/rec_size;
+    int dropped=0;
+    for (long l=Lib.recMax; l < recMaxPrev; l++) if ((nv.read(byteMin+l*rec_size+11)>>4) != 15) dropped++;
+    if (dropped > 0) { VF("WRN, initWriteNvValues(): Library, "); V(dropped); VLF(" records past the new end dropped"); }
+
+    // the park and focus model slots start out invalid, park falls back to the legacy position
+    for (int i=GSD; i < GSB; i++) nv.write(i,0);
+    nv.writeLong(EE_autoInitKey,NV_INIT_KEY);
+    VLF("MSG: NV migrated to the current format");
+  }
+
   if (nv.readLong(EE_autoInitKey) != NV_INIT_KEY) {
     // wipe the whole nv memory
     VF("MSG: Wipe NV "); V(E2END+1); VLF(" Bytes (please wait)");
+    nv.preload(0,E2END+1);
     for (int i=0; i<E2END; i++) nv.write(i,0);
 
     VLF("MSG: Init NV to defaults");
@@ -387,8 +405,8 @@ void initReadNvValues() {
   if (JD < 2451544.5 || JD > 2816787.5) JD=2451544.5; // valid date?
   if (LMT < 0 || LMT > 24) { LMT=0; generalError=ERR_NV_INIT; DLF("ERR, initReadNvValues(): bad NV LMT"); }
 
-  UT1=LMT+timeZone;
-  updateLST(jd2last(JD,UT1,false));
+  setUT1(LMT+timeZone);
+  updateLST(jd2last(JD,ut1Micros(),false));
 
   // get the degrees past meridian east/west
 #if MOUNT_TYPE == GEM
@@ -426,13 +444,14 @@ void initReadNvValues() {
   pecBufferSize=ceil(stepsPerWormRotationAxis1/(axis1Settings.stepsPerMeasure/240.0));
   if (pecBufferSize != 0) {
     if (pecBufferSize < 61) { pecBufferSize=0; generalError=ERR_NV_INIT; DLF("ERR, initReadNvValues(): invalid pecBufferSize, PEC disabled"); }
-    if (200+pecBufferSize >= E2END-200) { pecBufferSize=0; generalError=ERR_NV_INIT; DLF("ERR, initReadNvValues(): pecBufferSize exceeds available NV, PEC disabled"); }
+    if (200+pecBufferSize >= GSD) { pecBufferSize=0; generalError=ERR_NV_INIT; DLF("ERR, initReadNvValues(): pecBufferSize exceeds available NV, PEC disabled"); }
   }
   if (secondsPerWormRotationAxis1 > pecBufferSize) secondsPerWormRotationAxis1=pecBufferSize;
 
 #if AXIS1_PEC == ON
   createPecBuffer();
   bool pecBufferNeedsInit=true;
+  nv.preload(EE_pecTable,pecBufferSize);
   for (int i=0; i < pecBufferSize; i++) { pecBuffer[i]=nv.read(EE_pecTable+i); if (pecBuffer[i] != 0) pecBufferNeedsInit=false; }
   if (pecBufferNeedsInit) for (int l=0; l < pecBufferSize; l++) nv.write(EE_pecTable+l,128);
   wormSensePos=nv.readLong(EE_wormSensePos); // validation of this value is not useful
@@ -448,9 +467,9 @@ void initReadNvValues() {
   if (!pecRecorded) pecStatus=IgnorePEC;
 #endif
   
-  // get the Park status
-  parkSaved=nv.read(EE_parkSaved);
-  if (parkSaved != true && parkSaved != false) { parkSaved=false; generalError=ERR_NV_INIT; DLF("ERR, initReadNvValues(): bad NV parkSaved"); }
+  // get the Park status, the park record is CRC checked so only the fallback values need validation
+  readParkRecord();
+  parkSaved=getParkSaved();
   parkStatus=nv.read(EE_parkStatus);
   if (parkStatus < PARK_STATUS_FIRST || parkStatus > PARK_STATUS_LAST) { parkStatus=NotParked; generalError=ERR_NV_INIT; DLF("ERR, initReadNvValues(): bad NV parkStatus"); }
   // tried to park but crashed?
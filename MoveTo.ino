@@ -113,7 +113,7 @@ void moveTo() {
     }
 
     // set rate (in X sidereal) at which we slow down from
-    double rateXPerSec = RateToXPerSec/(maxRate/16.0);
+    double rateXPerSec = RateToXPerSec/(gotoRate()/16.0);
     double numSecToStop = (SLEW_RAPID_STOP_DIST/(rateXPerSec/240.0));
     deaccXPerSec = (SLEW_RAPID_STOP_DIST/numSecToStop)*240.0;
 
@@ -127,7 +127,7 @@ void moveTo() {
   } else {
     temp=(stepsForRateChangeAxis1/isqrt32(distStartAxis1));  // speed up (temp gets smaller)
   }
-  if (temp < maxRate) temp=maxRate;                          // fastest rate 
+  if (temp < gotoRate()) temp=gotoRate();                        // fastest rate 
   if (temp > backlashTakeupRate) temp=backlashTakeupRate;    // slowest rate
   if (abortGoto != 0) {
     if (abortGoto == 2) { a1r=(double)siderealRate/(double)temp; } else
@@ -146,7 +146,7 @@ void moveTo() {
   } else {
     temp=(stepsForRateChangeAxis2/isqrt32(distStartAxis2));  // speed up
   }
-  if (temp < maxRate) temp=maxRate;                          // fastest rate
+  if (temp < gotoRate()) temp=gotoRate();                        // fastest rate
   if (temp > backlashTakeupRate) temp=backlashTakeupRate;    // slowest rate
   if (abortGoto != 0) {
     if (abortGoto == 2) { a2r=(double)siderealRate/(double)temp; abortGoto++; } else
@@ -244,7 +244,7 @@ void moveTo() {
         SiderealClockSetInterval(siderealInterval);
 
         // validate location
-        byte parkPierSide=nv.read(EE_pierSide);
+        byte parkPierSide=getParkPierSide();
         if (pierSideControl != parkPierSide || pcbStatus != PCB_SUCCESS) { parkStatus=ParkFailed; nv.write(EE_parkStatus,parkStatus); }
 
         // sound park done
@@ -1,6 +1,49 @@
 // -----------------------------------------------------------------------------------
 // Functions related to Parking the mount
 
+// park position and index corrections, kept in a CRC protected A/B slot record (see src/lib/NvRecord.h)
+#pragma pack(1)
+typedef struct ParkRecord {
+  float   posAxis1;
+  float   posAxis2;
+  uint8_t pierSide;
+  uint8_t parkSaved;
+  float   indexAxis1;
+  float   indexAxis2;
+} parkRecord;
+#pragma pack()
+parkRecord parkRec = {0.0, 0.0, PierSideEast, false, 0.0, 0.0};
+
+// load the park record, falls back to (and range checks) the original separate NV values if no valid record exists
+bool readParkRecord() {
+  if (nvRecordRead(EE_parkRecordA,EE_parkRecordB,NV_PARK_RECORD_VERSION,(byte*)&parkRec,sizeof(parkRec))) return true;
+
+  VLF("MSG: No valid park record, using NV park values");
+  parkRec.posAxis1=nv.readFloat(EE_posAxis1);
+  parkRec.posAxis2=nv.readFloat(EE_posAxis2);
+  parkRec.pierSide=nv.read(EE_pierSide);
+  if (parkRec.pierSide != PierSideNone && parkRec.pierSide != PierSideEast && parkRec.pierSide != PierSideWest) { parkRec.pierSide=PierSideNone; DLF("ERR, readParkRecord(): bad NV parkPierSide"); }
+  parkRec.parkSaved=nv.read(EE_parkSaved);
+  if (parkRec.parkSaved != true && parkRec.parkSaved != false) { parkRec.parkSaved=false; generalError=ERR_NV_INIT; DLF("ERR, readParkRecord(): bad NV parkSaved"); }
+  parkRec.indexAxis1=nv.readFloat(EE_indexAxis1);
+  if (parkRec.indexAxis1 < -720 || parkRec.indexAxis1 > 720) { parkRec.indexAxis1=0; DLF("ERR, readParkRecord(): bad NV indexAxis1"); }
+  parkRec.indexAxis2=nv.readFloat(EE_indexAxis2);
+  if (parkRec.indexAxis2 < -720 || parkRec.indexAxis2 > 720) { parkRec.indexAxis2=0; DLF("ERR, readParkRecord(): bad NV indexAxis2"); }
+  return false;
+}
+
+void writeParkRecord() {
+  nvRecordWrite(EE_parkRecordA,EE_parkRecordB,NV_PARK_RECORD_VERSION,(byte*)&parkRec,sizeof(parkRec));
+}
+
+bool getParkSaved() {
+  return parkRec.parkSaved;
+}
+
+int getParkPierSide() {
+  return parkRec.pierSide;
+}
+
 // sets the park postion as the current position
 CommandErrors setPark() {
   if (parkStatus == ParkFailed)         return CE_PARK_FAILED;
@@ -14,15 +57,16 @@ CommandErrors setPark() {
   trackingState=TrackingNone;
 
   // store our position
-  nv.writeFloat(EE_posAxis1,getInstrAxis1());
-  nv.writeFloat(EE_posAxis2,getInstrAxis2());
-  int p=getInstrPierSide(); if (p == PierSideNone) nv.write(EE_pierSide,PierSideEast); else nv.write(EE_pierSide,p);
+  parkRec.posAxis1=getInstrAxis1();
+  parkRec.posAxis2=getInstrAxis2();
+  int p=getInstrPierSide(); if (p == PierSideNone) parkRec.pierSide=PierSideEast; else parkRec.pierSide=p;
 
   // record our park status
-  parkSaved=true; nv.write(EE_parkSaved,parkSaved);
+  parkSaved=true; parkRec.parkSaved=parkSaved;
 
-  // and remember what the index corrections are too (etc.)
+  // and remember what the index corrections are too (etc.), this also writes the park record
   saveAlignModel();
+  nv.flush();
 
   trackingState=lastTrackingState;
   
@@ -58,12 +102,12 @@ CommandErrors park() {
   // record our park status
   int lastParkStatus=parkStatus; 
   parkStatus=Parking; nv.write(EE_parkStatus,parkStatus);
+  nv.flush();
   
   // get suggested park position
-  double parkTargetAxis1=nv.readFloat(EE_posAxis1);
-  double parkTargetAxis2=nv.readFloat(EE_posAxis2);
-  int parkPierSide=nv.read(EE_pierSide);
-  if (parkPierSide != PierSideNone && parkPierSide != PierSideEast && parkPierSide != PierSideWest) { parkPierSide=PierSideNone; DLF("ERR, park(): bad NV parkPierSide"); }
+  double parkTargetAxis1=parkRec.posAxis1;
+  double parkTargetAxis2=parkRec.posAxis2;
+  int parkPierSide=parkRec.pierSide;
 
   // now, goto this target coordinate
   e=goTo(parkTargetAxis1,parkTargetAxis2,parkTargetAxis1,parkTargetAxis2,parkPierSide);
@@ -85,6 +129,7 @@ void parkFinish() {
     parkStatus=Parked; nv.write(EE_parkStatus,parkStatus);
     // store the pointing model
     saveAlignModel();
+    nv.flush();
     
     VLF("MSG: Parking done");
   } else { DLF("ERR, parkFinish(): Parking failed"); }
@@ -210,11 +255,10 @@ CommandErrors unPark(bool withTrackingOn) {
   loadAlignModel();
 
   // get suggested park position
-  int parkPierSide=nv.read(EE_pierSide);
-  if (parkPierSide != PierSideNone && parkPierSide != PierSideEast && parkPierSide != PierSideWest) { parkPierSide=PierSideNone; DLF("ERR, unPark(): bad NV parkPierSide"); }
+  int parkPierSide=parkRec.pierSide;
 
-  setTargetAxis1(nv.readFloat(EE_posAxis1),parkPierSide);
-  setTargetAxis2(nv.readFloat(EE_posAxis2),parkPierSide);
+  setTargetAxis1(parkRec.posAxis1,parkPierSide);
+  setTargetAxis2(parkRec.posAxis2,parkPierSide);
 
   // adjust target to the actual park position (just like we did when we parked)
   targetNearestParkPosition();
@@ -260,19 +304,18 @@ bool isParked() {
 bool saveAlignModel() {
   // and store our corrections
   Align.writeCoe();
-  nv.writeFloat(EE_indexAxis1,indexAxis1);
-  nv.writeFloat(EE_indexAxis2,indexAxis2);
+  parkRec.indexAxis1=indexAxis1;
+  parkRec.indexAxis2=indexAxis2;
+  writeParkRecord();
   return true;
 }
 
 bool loadAlignModel() {
   // get align/corrections
-  indexAxis1=nv.readFloat(EE_indexAxis1);
-  if (indexAxis1 < -720 || indexAxis1 > 720) { indexAxis1=0; DLF("ERR, loadAlignModel(): bad NV indexAxis1"); }
+  indexAxis1=parkRec.indexAxis1;
   indexAxis1Steps=(long)(indexAxis1*axis1Settings.stepsPerMeasure);
   
-  indexAxis2=nv.readFloat(EE_indexAxis2);
-  if (indexAxis2 < -720 || indexAxis2 > 720) { indexAxis2=0; DLF("ERR, loadAlignModel(): bad NV indexAxis2"); }
+  indexAxis2=parkRec.indexAxis2;
   indexAxis2Steps=(long)(indexAxis2*axis2Settings.stepsPerMeasure);
   
   Align.readCoe();
@@ -199,6 +199,73 @@ void axis2DriverGotoMode() {
   }
 #endif
 
+#if AXIS1_DRIVER_STATUS == TMC_SPI && AXIS2_DRIVER_STATUS == TMC_SPI
+// -----------------------------------------------------------------------------------
+// Load monitoring, samples stallGuard (SG_RESULT, lower is more load) and the current scale (CS_ACTUAL) during gotos
+// with GOTO_RATE_ADAPTIVE the goto rate creeps up while both axes show margin and backs off quickly when either doesn't
+
+typedef struct DriverLoad {
+  int sg;                                                    // last SG_RESULT, 0..1023
+  int sgMin;                                                 // lowest SG_RESULT at speed this goto
+  int cs;                                                    // last CS_ACTUAL, 0..31
+  bool atSpeed;                                              // last sample was taken near the goto rate
+} driverLoad;
+
+driverLoad loadAxis[2] = {{-1,-1,-1,false},{-1,-1,-1,false}};
+
+// call at the start of each goto
+void loadReset() {
+  for (int i=0; i < 2; i++) { loadAxis[i].sgMin=-1; loadAxis[i].atSpeed=false; }
+}
+
+void loadUpdate(int i, int sg, int cs, long timerRate) {
+  loadAxis[i].sg=sg;
+  loadAxis[i].cs=cs;
+  // below about half speed the SG_RESULT doesn't mean much
+  loadAxis[i].atSpeed=timerRate <= gotoRate()*2 && abortGoto == 0;
+  if (loadAxis[i].atSpeed && (loadAxis[i].sgMin < 0 || sg < loadAxis[i].sgMin)) loadAxis[i].sgMin=sg;
+}
+
+// samples one axis per call, alternating
+void loadSample() {
+  static bool axis2=false;
+  long r1,r2;
+  cli(); r1=timerRateAxis1; r2=timerRateAxis2; sei();
+  if (axis2) {
+    tmcAxis2.refresh_DRVSTATUS();
+    loadUpdate(1,tmcAxis2.get_DRVSTATUS_SG_RESULT(),tmcAxis2.get_DRVSTATUS_CS_ACTUAL(),r2);
+  } else {
+    tmcAxis1.refresh_DRVSTATUS();
+    loadUpdate(0,tmcAxis1.get_DRVSTATUS_SG_RESULT(),tmcAxis1.get_DRVSTATUS_CS_ACTUAL(),r1);
+  }
+  axis2=!axis2;
+
+#if GOTO_RATE_ADAPTIVE == ON
+  // axes that aren't at speed don't count
+  bool sampled=false, low=false, high=true;
+  for (int i=0; i < 2; i++) {
+    if (!loadAxis[i].atSpeed) continue;
+    sampled=true;
+    if (loadAxis[i].sg < GOTO_RATE_ADAPTIVE_SG_LOW) low=true;
+    if (loadAxis[i].sg <= GOTO_RATE_ADAPTIVE_SG_HIGH) high=false;
+  }
+  if (!sampled) return;
+  // backs off to at most half speed (2x the maxRate interval,) speeds up to at most 2x but never past maxRateLowerLimit()
+  if (low) { gotoRateScale+=gotoRateScale/4; if (gotoRateScale > 512) gotoRateScale=512; } else
+  if (high) {
+    gotoRateScale-=gotoRateScale/32; if (gotoRateScale < 128) gotoRateScale=128;
+    if (gotoRate() < maxRateLowerLimit()) gotoRateScale=(maxRateLowerLimit()*256L+maxRate-1)/maxRate;
+  }
+#endif
+}
+
+// load as "sg1,sgMin1,cs1,sg2,sgMin2,cs2,r" where r is the goto rate in us/step
+void loadStatus(char *reply) {
+  char r[12]; dtostrf(gotoRate()/16.0,3,3,r);
+  sprintf(reply,"%d,%d,%d,%d,%d,%d,%s",loadAxis[0].sg,loadAxis[0].sgMin,loadAxis[0].cs,loadAxis[1].sg,loadAxis[1].sgMin,loadAxis[1].cs,r);
+}
+#endif
+
 #else
 // ---------------------------------------------------------------------------------------------------
 // traditional s/d stepper drivers
@@ -0,0 +1,406 @@
+// -----------------------------------------------------------------------------------
+// Tasks, the work of loop2() as named tasks run by the cooperative scheduler
+
+// period (us), priority (0 is highest,) and budget (us) for each task, priority 0 tasks run whenever due
+// the rest only start if their budget fits in what's left of the current 1/100s slot
+void initTasks() {
+  tasks.add("ST4",         taskSt4,           0,       0,  100);
+  tasks.add("guide",       taskGuide,         0,       0,  300);
+#if HOME_SENSE != OFF
+  tasks.add("home",        taskHome,          0,       0,  100);
+#endif
+  tasks.add("sidereal",    taskSidereal,      0,       0, 2000);
+#if AXIS1_DRIVER_MODEL == TMC_SPI
+  tasks.add("modeSwitch",  taskModeSwitch,    0,       0,  200);
+#endif
+#if AXIS1_DRIVER_STATUS == TMC_SPI && AXIS2_DRIVER_STATUS == TMC_SPI
+  tasks.add("load",        taskLoad,      20000,       1,  300);
+#endif
+#if ROTATOR == ON || FOCUSER1 == ON || FOCUSER2 == ON
+  tasks.add("follow",      taskFollow,        0,       0,  200);
+#endif
+  tasks.add("altCalc",     taskAltCalc,   30000,       1, 1000);
+  tasks.add("rateCalc",    taskRateCalc,  15000,       1, 1000);
+  tasks.add("commands",    taskCommands,      0,       1, 3000);
+  tasks.add("housekeeping",taskHousekeeping,1000000,   2, 2000);
+#if FOCUSER1 == ON
+  tasks.add("autofocus",   taskAutofocus, 100000,       2,  100);
+#endif
+#if TIME_LOCATION_SOURCE == GPS
+  tasks.add("GPS",         taskGps,       10000,       2,  500);
+#endif
+#ifdef FEATURES_PRESENT
+  tasks.add("features",    taskFeatures,  10000,       2,  500);
+#endif
+  tasks.add("weather",     taskWeather,   10000,       3, 2000);
+  tasks.add("NV",          taskNv,            0,       3,  500);
+#if TELEMETRY_LOG != OFF
+  tasks.add("telemetry",   taskTelemetry,     0,       3,  300);
+#endif
+#if defined(AddonTriggerPin) || (DEBUG == VERBOSE && DEBUG_NV == ON)
+  tasks.add("misc",        taskMisc,      10000,       3,  100);
+#endif
+}
+
+// GUIDING -------------------------------------------------------------------------------------------
+bool taskSt4() {
+  PROFILE_START(PS_ST4);
+  ST4();
+  PROFILE_STOP(PS_ST4);
+  return true;
+}
+
+bool taskGuide() {
+  if ((trackingState != TrackingMoveTo) && (parkStatus == NotParked)) {
+    PROFILE_START(PS_GUIDE);
+    guide();
+    PROFILE_STOP(PS_GUIDE);
+    return true;
+  }
+  return false;
+}
+
+#if HOME_SENSE != OFF
+// AUTOMATIC HOMING ----------------------------------------------------------------------------------
+bool taskHome() {
+  checkHome();
+  return true;
+}
+#endif
+
+// 1/100 SECOND TIMED --------------------------------------------------------------------------------
+bool taskSidereal() {
+  cli(); long lstNow=lst; sei();
+  if (lstNow == siderealTimer) return false;
+  siderealTimer=lstNow;
+  tasks.slotStart();
+
+#ifdef ESP32
+  timerSupervisor(true);
+#endif
+  
+#if AXIS1_PEC == ON
+  // PERIODIC ERROR CORRECTION
+  PROFILE_START(PS_PEC);
+  pec();
+  PROFILE_STOP(PS_PEC);
+#endif
+
+#if TELEMETRY_LOG != OFF
+  // TRACKING/GUIDING TELEMETRY LOG
+  telemetrySample();
+#endif
+
+  // FLASH LED DURING SIDEREAL TRACKING
+#if LED_STATUS == ON
+  if (trackingState == TrackingSidereal) {
+    if (siderealTimer%20L == 0L) { if (ledOn) { digitalWrite(LEDnegPin,HIGH); ledOn=false; } else { digitalWrite(LEDnegPin,LOW); ledOn=true; } }
+  }
+#endif
+
+  // SIDEREAL TRACKING DURING GOTOS
+  // keeps the target where it's supposed to be while doing gotos
+  if (trackingState == TrackingMoveTo) {
+    PROFILE_START(PS_MOVETO);
+    moveTo();
+    PROFILE_STOP(PS_MOVETO);
+    if (lastTrackingState == TrackingSidereal) {
+      origTargetAxis1.fixed+=fstepAxis1.fixed;
+      origTargetAxis2.fixed+=fstepAxis2.fixed;
+      // don't advance the target during meridian flips or sync
+      if (getInstrPierSide() == PierSideEast || getInstrPierSide() == PierSideWest) {
+        cli();
+        targetAxis1.fixed+=fstepAxis1.fixed;
+        targetAxis2.fixed+=fstepAxis2.fixed;
+        sei();
+      }
+    }
+  }
+
+  // ROTATOR/FOCUSERS, MOVE THE TARGET
+#if ROTATOR == ON
+  rot.poll(trackingState == TrackingSidereal);
+#endif
+#if FOCUSER1 == ON
+  foc1.poll();
+#endif
+#if FOCUSER2 == ON
+  foc2.poll();
+#endif
+
+  // SAFETY CHECKS
+#if LIMIT_SENSE != OFF
+  // support for limit switch(es)
+  byte limit_1st = digitalRead(LimitPin);
+  if (limit_1st == LIMIT_SENSE_STATE) {
+    // Wait for a short while, then read again
+    delayMicroseconds(50);
+    byte limit_2nd = digitalRead(LimitPin);
+    if (limit_2nd == LIMIT_SENSE_STATE) {
+      // It is still low, there must be a problem
+      generalError=ERR_LIMIT_SENSE;
+      stopSlewingAndTracking(SS_LIMIT);
+    } 
+  }
+#endif
+
+  // check for fault signal, stop any slew or guide and turn tracking off
+#if AXIS1_DRIVER_STATUS == LOW || AXIS1_DRIVER_STATUS == HIGH
+  faultAxis1=(digitalRead(Axis1_FAULT) == AXIS1_DRIVER_STATUS);
+#elif AXIS1_DRIVER_STATUS == TMC_SPI
+  if (siderealTimer%2 == 0) faultAxis1=tmcAxis1.error();
+#endif
+#if AXIS2_DRIVER_STATUS == LOW || AXIS2_DRIVER_STATUS == HIGH
+  faultAxis2=(digitalRead(Axis2_FAULT) == AXIS2_DRIVER_STATUS);
+#elif AXIS2_DRIVER_STATUS == TMC_SPI
+  if (siderealTimer%2 == 1) faultAxis2=tmcAxis2.error();
+#endif
+
+  if (faultAxis1 || faultAxis2) { generalError=ERR_MOTOR_FAULT; stopSlewingAndTracking(SS_LIMIT_HARD); }
+
+  if (safetyLimitsOn) {
+    // check altitude overhead limit and horizon limit
+    if (currentAlt < minAlt) { generalError=ERR_ALT_MIN; stopSlewingAndTracking((MOUNT_TYPE == ALTAZM)?SS_LIMIT_AXIS2_MIN:SS_LIMIT); }
+    if (currentAlt > maxAlt) { generalError=ERR_ALT_MAX; stopSlewingAndTracking((MOUNT_TYPE == ALTAZM)?SS_LIMIT_AXIS2_MAX:SS_LIMIT); }
+  }
+
+  // OPTION TO POWER DOWN AXIS2 IF NOT MOVING
+#if AXIS2_DRIVER_POWER_DOWN == ON && MOUNT_TYPE != ALTAZM
+  autoPowerDownAxis2();
+#endif
+
+  // UPDATE THE UT1 CLOCK
+  updateUT1();
+
+  return true;
+}
+
+// CALCULATE SOME TRACKING RATES, ETC.
+bool taskAltCalc() {
+  PROFILE_START(PS_ALT_CALC);
+  doFastAltCalc(false);
+  PROFILE_STOP(PS_ALT_CALC);
+  return true;
+}
+
+bool taskRateCalc() {
+#if MOUNT_TYPE == ALTAZM
+  // figure out the current Alt/Azm tracking rates
+  PROFILE_START(PS_RATE_CALC);
+  doHorRateCalc();
+  PROFILE_STOP(PS_RATE_CALC);
+  return true;
+#else
+  // figure out the current refraction compensated tracking rate
+  if (rateCompensation != RC_NONE) {
+    PROFILE_START(PS_RATE_CALC);
+    doRefractionRateCalc();
+    PROFILE_STOP(PS_RATE_CALC);
+    return true;
+  }
+  return false;
+#endif
+}
+
+#if TIME_LOCATION_SOURCE == GPS
+// 0.01S POLLING -------------------------------------------------------------------------------------
+bool taskGps() {
+  if ((PPS_SENSE == OFF || ppsSynced) && tls.poll()) {
+    gpsSynced = true;
+    
+    SerialGPS.end();
+    currentSite=0; 
+    nv.update(EE_currentSite,currentSite);
+    
+
+    tls.getLocation(&latitude, &longitude);
+    tls.get(JD,LMT);
+
+    timeZone=nv.read(EE_sites+currentSite*25+8)-128;
+    timeZone=decodeTimeZone(timeZone);
+
+    setUT1(LMT+timeZone);
+
+    nv.writeString(EE_sites+currentSite*25+9,(char*)"GPS");
+    setLatitude(latitude);  //Set and STORE latitude
+    nv.writeFloat(EE_sites+currentSite*25+4,longitude);
+    updateLST(jd2last(JD,ut1Micros(),false));
+
+    if (generalError == ERR_SITE_INIT) generalError=ERR_NONE;
+
+    dateWasSet=true;
+    timeWasSet=true;
+    VLF("MSG: Successfully got GPS TLS");
+    soundBeep();
+    return true;
+  }
+  return false;
+}
+#endif
+
+#ifdef FEATURES_PRESENT
+// UPDATE AUXILIARY FEATURES
+bool taskFeatures() {
+  featuresPoll();
+  return true;
+}
+#endif
+
+#if FOCUSER1 == ON
+// AUTOFOCUS SEQUENCER
+bool taskAutofocus() {
+  return autofocus.poll();
+}
+#endif
+
+// WEATHER
+bool taskWeather() {
+  PROFILE_START(PS_WEATHER);
+  ambient.poll(isSlewing());
+  PROFILE_STOP(PS_WEATHER);
+  return true;
+}
+
+#if defined(AddonTriggerPin) || (DEBUG == VERBOSE && DEBUG_NV == ON)
+bool taskMisc() {
+  // MONITOR NV CACHE
+#if DEBUG == VERBOSE && DEBUG_NV == ON
+  static bool lastCommitted=true;
+  bool committed=nv.committed();
+  if (committed && !lastCommitted) { DLF("MSG: NV commit done"); lastCommitted=committed; }
+  if (!committed && lastCommitted) { DLF("MSG: NV data in cache"); lastCommitted=committed; }
+#endif
+
+  // TRIGGER ESPFLASH
+#if defined(AddonTriggerPin)
+  fa.poll();
+#endif
+  return true;
+}
+#endif
+
+// FASTEST POLLING -----------------------------------------------------------------------------------
+#if AXIS1_DRIVER_MODEL == TMC_SPI
+bool taskModeSwitch() {
+  autoModeSwitch();
+  return true;
+}
+#endif
+
+#if AXIS1_DRIVER_STATUS == TMC_SPI && AXIS2_DRIVER_STATUS == TMC_SPI
+// STALLGUARD/CURRENT SCALE SAMPLING DURING GOTOS
+bool taskLoad() {
+  if (trackingState != TrackingMoveTo) return false;
+  loadSample();
+  return true;
+}
+#endif
+
+#if ROTATOR == ON || FOCUSER1 == ON || FOCUSER2 == ON
+bool taskFollow() {
+  PROFILE_START(PS_FOLLOW);
+#if ROTATOR == ON
+  rot.follow(isSlewing());
+#endif
+#if FOCUSER1 == ON
+  foc1.follow(isSlewing());
+#endif
+#if FOCUSER2 == ON
+  foc2.follow(isSlewing());
+#endif
+  PROFILE_STOP(PS_FOLLOW);
+  return true;
+}
+#endif
+
+bool taskNv() {
+  if (!isSlewing()) {
+    PROFILE_START(PS_NV);
+    nv.poll();
+    PROFILE_STOP(PS_NV);
+    return true;
+  }
+  return false;
+}
+
+#if TELEMETRY_LOG != OFF
+bool taskTelemetry() {
+  telemetryPoll();
+  return true;
+}
+#endif
+
+// COMMAND PROCESSING --------------------------------------------------------------------------------
+bool taskCommands() {
+  PROFILE_START(PS_COMMANDS);
+  processCommands();
+  PROFILE_STOP(PS_COMMANDS);
+  return true;
+}
+
+// 1 SECOND TIMED ------------------------------------------------------------------------------------
+bool taskHousekeeping() {
+#if ROTATOR == ON && MOUNT_TYPE == ALTAZM
+  // resynchronize the derotation model, the rotator advances it every 1/100 second
+  double h,d; getApproxEqu(&h,&d,true);
+  if (trackingState == TrackingSidereal) rot.derotate(h,d);
+#endif
+
+  // adjust tracking rate for Alt/Azm mounts
+  // adjust tracking rate for refraction
+  setDeltaTrackingRate();
+
+  // basic check to see if we're not at home
+  if (trackingState != TrackingNone) atHome=false;
+
+#if PPS_SENSE != OFF
+  // update clock via PPS
+  cli();
+  if ((long)(micros()-(ppsLastMicroS+2000000UL)) > 0) ppsSynced=false; // if more than two seconds has ellapsed without a pulse we've lost sync
+  sei();
+  ppsDiscipline();
+  #if LED_STATUS2 == ON
+  if (trackingState == TrackingSidereal) {
+    if (ppsSynced) { if (led2On) { digitalWrite(LEDneg2Pin,HIGH); led2On=false; } else { digitalWrite(LEDneg2Pin,LOW); led2On=true; } } else { digitalWrite(LEDneg2Pin,HIGH); led2On=false; } // indicate PPS
+  }
+  #endif
+  if (ppsLastRateRatio != ppsRateRatio) { SiderealClockSetInterval(siderealInterval); ppsLastRateRatio=ppsRateRatio; }
+#endif
+
+#if LED_STATUS == ON
+  // LED indicate PWR on 
+  if (trackingState != TrackingSidereal) if (!ledOn) { digitalWrite(LEDnegPin,LOW); ledOn=true; }
+#endif
+#if LED_STATUS2 == ON
+  // LED indicate STOP and GOTO
+  if (trackingState == TrackingMoveTo) if (!led2On) { digitalWrite(LEDneg2Pin,LOW); led2On=true; }
+  #if PPS_SENSE != OFF
+  if (trackingState == TrackingNone) if (led2On) { digitalWrite(LEDneg2Pin,HIGH); led2On=false; }
+  #else
+  if (trackingState != TrackingMoveTo) if (led2On) { digitalWrite(LEDneg2Pin,HIGH); led2On=false; }
+  #endif
+#endif
+
+  // SAFETY CHECKS -------------------------------------------------------------------------------------
+  // keeps mount from tracking past the meridian limit, past the AXIS1_LIMIT_MAX, or past the Dec limits
+  if (safetyLimitsOn) {
+    // check for exceeding AXIS1_LIMIT_MIN or AXIS1_LIMIT_MAX
+    if (getInstrAxis1() < axis1Settings.min) { generalError=(MOUNT_TYPE==ALTAZM)?ERR_AZM:ERR_UNDER_POLE; stopSlewingAndTracking(SS_LIMIT_AXIS1_MIN); } else
+    if (getInstrAxis1() > axis1Settings.max) { generalError=(MOUNT_TYPE==ALTAZM)?ERR_AZM:ERR_UNDER_POLE; stopSlewingAndTracking(SS_LIMIT_AXIS1_MAX); } else
+    // check for exceeding Meridian Limits
+    if (meridianFlip != MeridianFlipNever) {
+      if (getInstrPierSide() == PierSideWest) {
+        if (getInstrAxis1() > degreesPastMeridianW && (!(autoMeridianFlip && goToHere(true) == CE_NONE))) { generalError=ERR_MERIDIAN; stopSlewingAndTracking(SS_LIMIT_AXIS1_MAX); }
+      } else
+      if (getInstrAxis1() < -degreesPastMeridianE) { generalError=ERR_MERIDIAN; stopSlewingAndTracking(SS_LIMIT_AXIS1_MIN); }
+    }
+  }
+  double a2; if (AXIS2_TANGENT_ARM == ON) { cli(); a2=posAxis2/axis2Settings.stepsPerMeasure; sei(); } else a2=getInstrAxis2();
+  // check for exceeding AXIS2_LIMIT_MIN or AXIS2_LIMIT_MAX
+  if (a2 < axis2Settings.min) { generalError=ERR_DEC; stopSlewingAndTracking(SS_LIMIT_AXIS2_MIN); } else
+  if (a2 > axis2Settings.max) { generalError=ERR_DEC; stopSlewingAndTracking(SS_LIMIT_AXIS2_MAX); } else
+  // automatically clear error in TA mode
+  if (AXIS2_TANGENT_ARM == ON && (trackingState == TrackingSidereal && generalError == ERR_DEC)) generalError=ERR_NONE;
+
+  return true;
+}
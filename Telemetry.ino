@@ -0,0 +1,102 @@
+// -----------------------------------------------------------------------------------
+// Telemetry, ring buffered log of tracking and guiding samples for offline analysis
+
+#if TELEMETRY_LOG != OFF
+
+#pragma pack(1)
+typedef struct TelemetryRecord {
+  uint32_t lst;                                              // sidereal time in 0.01 second ticks
+  int32_t  posAxis1;                                         // RA/Azm motor position in steps
+  int32_t  posAxis2;                                         // Dec/Alt motor position in steps
+  int32_t  guideAxis1;                                       // RA/Azm guide steps this tick, 16.16 fixed point
+  int16_t  pecRateAxis1;                                     // PEC rate adjustment in 1/10000 x sidereal
+  char     guideDirAxis1;                                    // 'e', 'w', 'b' or 0
+  char     guideDirAxis2;                                    // 'n', 's', 'b' or 0
+} telemetryRecord;
+#pragma pack()
+
+telemetryRecord telemetryBuffer[TELEMETRY_LOG];
+int     telemetryHead           = 0;                         // index of the next record to be written
+int     telemetryCount          = 0;                         // number of valid records in the buffer
+bool    telemetryLogging        = false;
+Stream *telemetryPort           = NULL;                      // command channel a dump is streaming to
+int     telemetryDumpIndex      = 0;                         // next record to be sent
+int     telemetryDumpRemaining  = 0;                         // records left to send
+bool    telemetryPortFlow       = false;                     // true once the port has reported room in its transmit buffer
+
+// record one sample, called once every 1/100 second
+void telemetrySample() {
+  if (!telemetryLogging || telemetryPort != NULL) return;
+
+  telemetryRecord *r=&telemetryBuffer[telemetryHead];
+  cli();
+  r->lst=lst;
+  r->posAxis1=posAxis1;
+  r->posAxis2=posAxis2;
+  sei();
+  r->guideAxis1=(int32_t)((int64_t)guideAxis1.fixed>>16);
+  r->pecRateAxis1=(int16_t)round(pecTimerRateAxis1*10000.0);
+  r->guideDirAxis1=guideDirAxis1;
+  r->guideDirAxis2=guideDirAxis2;
+
+  telemetryHead++; if (telemetryHead >= TELEMETRY_LOG) telemetryHead=0;
+  if (telemetryCount < TELEMETRY_LOG) telemetryCount++;
+}
+
+// send any pending dump records that fit in the transmit buffer, never blocking the main loop
+// ports that don't implement availableForWrite() (it's always 0) get TELEMETRY_DUMP_RECORDS records per poll instead
+void telemetryPoll() {
+  if (telemetryPort == NULL) return;
+
+  int a=telemetryPort->availableForWrite();
+  if (a > 0) telemetryPortFlow=true;
+  int n=a/sizeof(telemetryRecord);
+  if (!telemetryPortFlow) n=TELEMETRY_DUMP_RECORDS;
+  if (n < 1) return;
+  while (n > 0 && telemetryDumpRemaining > 0) {
+    telemetryPort->write((uint8_t*)&telemetryBuffer[telemetryDumpIndex],sizeof(telemetryRecord));
+    telemetryDumpIndex++; if (telemetryDumpIndex >= TELEMETRY_LOG) telemetryDumpIndex=0;
+    telemetryDumpRemaining--;
+    n--;
+  }
+  if (telemetryDumpRemaining == 0) telemetryPort=NULL;
+}
+
+void telemetryStart() {
+  telemetryLogging=true;
+}
+
+void telemetryStop() {
+  telemetryLogging=false;
+}
+
+void telemetryClear() {
+  telemetryHead=0;
+  telemetryCount=0;
+}
+
+bool telemetryDumping() {
+  return telemetryPort != NULL;
+}
+
+// start streaming the log (oldest record first) to port, returns the number of records that will be sent
+int telemetryDump(Stream *port) {
+  telemetryDumpIndex=telemetryHead-telemetryCount; if (telemetryDumpIndex < 0) telemetryDumpIndex+=TELEMETRY_LOG;
+  telemetryDumpRemaining=telemetryCount;
+  telemetryPortFlow=false;
+  if (telemetryDumpRemaining > 0) telemetryPort=port;
+  return telemetryDumpRemaining;
+}
+
+// stops a dump that's underway, the records not yet sent are dropped
+void telemetryAbort() {
+  telemetryDumpRemaining=0;
+  telemetryPort=NULL;
+}
+
+// status as "l,n,m,s" where l is logging (0 or 1), n is the number of records, m is the capacity and s is the record size in bytes
+void telemetryStatus(char *reply) {
+  sprintf(reply,"%d,%d,%d,%d",(int)telemetryLogging,telemetryCount,(int)TELEMETRY_LOG,(int)sizeof(telemetryRecord));
+}
+
+#endif
@@ -21,11 +21,13 @@
 #if defined(AXIS1_DRIVER_CODE) && defined(AXIS1_DRIVER_CODE_GOTO)
   volatile long AXIS1_DRIVER_CODE_NEXT=AXIS1_DRIVER_CODE;
   volatile bool gotoModeAxis1=false;
+  volatile long modeSwitchAtAxis1=0;                         // position (plus backlash) where the goto micro-steps line up next
 #endif
 
 #if defined(AXIS2_DRIVER_CODE) && defined(AXIS2_DRIVER_CODE_GOTO)
   volatile long AXIS2_DRIVER_CODE_NEXT=AXIS2_DRIVER_CODE;
   volatile bool gotoModeAxis2=false;
+  volatile long modeSwitchAtAxis2=0;                         // position (plus backlash) where the goto micro-steps line up next
 #endif
 
 volatile bool axis2Powered = true;
@@ -76,6 +78,15 @@ volatile byte lastGuideDirAxis1=0;
 volatile byte guideDirChangeTimerAxis2=0;
 volatile byte lastGuideDirAxis2=0;
 
+// time in uS between timerSupervisor() calls while not in a goto, 1/100 or 1/300 sidereal second
+#if defined(HAL_FAST_PROCESSOR) && !defined(ESP32)
+  #define GUIDE_PULSE_PERIOD 3324L
+  #define GUIDE_PULSE_PERIODS_CS 3.0
+#else
+  #define GUIDE_PULSE_PERIOD 9973L
+  #define GUIDE_PULSE_PERIODS_CS 1.0
+#endif
+
 #ifdef HAL_USE_NOBLOCK_FOR_TIMER1
 ISR(TIMER1_COMPA_vect,ISR_NOBLOCK)
 #else
@@ -99,6 +110,9 @@ IRAM_ATTR ISR(TIMER1_COMPA_vect)
   }
   
   if (centiSecond) {
+#if PPS_SENSE != OFF
+    lstMicroS=micros();
+#endif
     lst++;
     // handle buzzer
     if (buzzerDuration > 0) { buzzerDuration--; if (buzzerDuration == 0) digitalWrite(TonePin,LOW); }
@@ -126,7 +140,14 @@ void timerSupervisor(bool isCentiSecond) {
         // slow speed guiding, no acceleration
         guideTimerRateAxis1A=guideTimerRateAxis1;
         // break
-        if (guideDirAxis1 == 'b') { guideDirAxis1=0; guideTimerRateAxis1=0.0; guideTimerRateAxis1A=0.0; }
+        if (guideDirAxis1 == 'b' || guidePulseRemainingAxis1 == 0) { guideDirAxis1=0; guidePulseRemainingAxis1=-1; guideTimerRateAxis1=0.0; guideTimerRateAxis1A=0.0; } else
+        // pulse guide, count down the time at rate and scale the rate for the last partial period so the step count is exact
+        if (guidePulseRemainingAxis1 > 0 && !inbacklashAxis1) {
+          double f=1.0;
+          if (guidePulseRemainingAxis1 < GUIDE_PULSE_PERIOD) { f=(double)guidePulseRemainingAxis1/GUIDE_PULSE_PERIOD; guideTimerRateAxis1A*=f; guidePulseRemainingAxis1=0; } else guidePulseRemainingAxis1-=GUIDE_PULSE_PERIOD;
+          // the part of 1/100 second moved at guide rate, for PEC recording
+          if (guideTimerRateAxis1 < 0) guidePulseMovedAxis1-=f/GUIDE_PULSE_PERIODS_CS; else guidePulseMovedAxis1+=f/GUIDE_PULSE_PERIODS_CS;
+        }
       } else {
         if ((isCentiSecond) && (!inbacklashAxis1)) {
           // high speed guiding
@@ -155,6 +176,9 @@ void timerSupervisor(bool isCentiSecond) {
     } else guideTimerRateAxis1A=0.0;
 
     double timerRateAxis1B=guideTimerRateAxis1A+pecTimerRateAxis1+trackingTimerRateAxis1;
+#if GUIDE_CONTROL == ON
+    timerRateAxis1B+=guideControlRateAxis1;
+#endif
     if (timerRateAxis1B < -0.00001) { timerRateAxis1B=fabs(timerRateAxis1B); cli(); timerDirAxis1=-1; sei(); } else 
       if (timerRateAxis1B > 0.00001) { cli(); timerDirAxis1=1; sei(); } else { cli(); timerDirAxis1=0; sei(); timerRateAxis1B=1.0; }
     double f = round(siderealRate/timerRateAxis1B);
@@ -169,7 +193,11 @@ void timerSupervisor(bool isCentiSecond) {
         // slow speed guiding, no acceleration
         guideTimerRateAxis2A=guideTimerRateAxis2; 
         // break mode
-        if (guideDirAxis2 == 'b') { guideDirAxis2=0; guideTimerRateAxis2=0.0; guideTimerRateAxis2A=0.0; }
+        if (guideDirAxis2 == 'b' || guidePulseRemainingAxis2 == 0) { guideDirAxis2=0; guidePulseRemainingAxis2=-1; guideTimerRateAxis2=0.0; guideTimerRateAxis2A=0.0; } else
+        // pulse guide, count down the time at rate and scale the rate for the last partial period
+        if (guidePulseRemainingAxis2 > 0 && !inbacklashAxis2) {
+          if (guidePulseRemainingAxis2 < GUIDE_PULSE_PERIOD) { guideTimerRateAxis2A*=(double)guidePulseRemainingAxis2/GUIDE_PULSE_PERIOD; guidePulseRemainingAxis2=0; } else guidePulseRemainingAxis2-=GUIDE_PULSE_PERIOD;
+        }
       } else {
         if ((isCentiSecond) && (!inbacklashAxis2)) {
           // use acceleration
@@ -198,6 +226,9 @@ void timerSupervisor(bool isCentiSecond) {
     } else guideTimerRateAxis2A=0.0;
 
     double timerRateAxis2B=guideTimerRateAxis2A+trackingTimerRateAxis2;
+#if GUIDE_CONTROL == ON
+    timerRateAxis2B+=guideControlRateAxis2;
+#endif
     if (timerRateAxis2B < -0.0001) { timerRateAxis2B=fabs(timerRateAxis2B); cli(); timerDirAxis2=-1; sei(); } else
       if (timerRateAxis2B > 0.0001) { cli(); timerDirAxis2=1; sei(); } else { cli(); timerDirAxis2=0; sei(); timerRateAxis2B=1.0; }
     f = round(siderealRate/timerRateAxis2B);
@@ -218,9 +249,23 @@ void timerSupervisor(bool isCentiSecond) {
   // trigger goto step mode
 #if defined(AXIS1_DRIVER_CODE) && defined(AXIS1_DRIVER_CODE_GOTO) && MODE_SWITCH_BEFORE_SLEW == OFF
   gotoRateAxis1=(thisTimerRateAxis1 < AXIS1_DRIVER_SWITCH_RATE);
+  // arm the switch to goto mode at the next position in the direction of travel where the goto micro-steps line up
+  if (gotoRateAxis1 && !gotoModeAxis1) {
+    cli(); long p=posAxis1+blAxis1; byte d=dirAxis1; sei();
+    long phase=(unsigned long)p%axis1StepsGoto;
+    if (d == 1 && phase != 0) p+=axis1StepsGoto-phase; else p-=phase;
+    cli(); modeSwitchAtAxis1=p; sei();
+  }
 #endif
 #if defined(AXIS2_DRIVER_CODE) && defined(AXIS2_DRIVER_CODE_GOTO) && MODE_SWITCH_BEFORE_SLEW == OFF
   gotoRateAxis2=(thisTimerRateAxis2 < AXIS2_DRIVER_SWITCH_RATE);
+  // arm the switch to goto mode at the next position in the direction of travel where the goto micro-steps line up
+  if (gotoRateAxis2 && !gotoModeAxis2) {
+    cli(); long p=posAxis2+blAxis2; byte d=dirAxis2; sei();
+    long phase=(unsigned long)p%axis2StepsGoto;
+    if (d == 1 && phase != 0) p+=axis2StepsGoto-phase; else p-=phase;
+    cli(); modeSwitchAtAxis2=p; sei();
+  }
 #endif
 
   // set the rates
@@ -270,8 +315,8 @@ IRAM_ATTR ISR(TIMER3_COMPA_vect)
 #if MODE_SWITCH_BEFORE_SLEW == OFF && defined(AXIS1_DRIVER_CODE_GOTO)
   // switch micro-step mode
   if (gotoModeAxis1 != gotoRateAxis1) {
-    // only when at an allowed position
-    if (gotoModeAxis1 || (posAxis1+blAxis1)%axis1StepsGoto == 0) {
+    // only at the position timerSupervisor() armed, it's rearmed every call so a change of direction is picked up
+    if (gotoModeAxis1 || posAxis1+blAxis1 == modeSwitchAtAxis1) {
       if (gotoModeAxis1) { gotoModeAxis1=false; axis1DriverTrackingFast(); } else { gotoModeAxis1=true; axis1DriverGotoFast(); }
     }
   }
@@ -363,8 +408,8 @@ IRAM_ATTR ISR(TIMER4_COMPA_vect)
 #if MODE_SWITCH_BEFORE_SLEW == OFF && defined(AXIS2_DRIVER_CODE_GOTO)
   // switch micro-step mode
   if (gotoModeAxis2 != gotoRateAxis2) {
-    // only when at an allowed position
-    if (gotoModeAxis2 || (posAxis2+blAxis2)%axis2StepsGoto == 0) {
+    // only at the position timerSupervisor() armed, it's rearmed every call so a change of direction is picked up
+    if (gotoModeAxis2 || posAxis2+blAxis2 == modeSwitchAtAxis2) {
       if (gotoModeAxis2) { gotoModeAxis2=false; axis2DriverTrackingFast(); } else { gotoModeAxis2=true; axis2DriverGotoFast(); }
     }
   }
@@ -476,13 +521,79 @@ double getFrequencyHzAxis2() {
 #if PPS_SENSE != OFF
 // PPS interrupt
 void clockSync() {
-  #define NUM_SECS_TO_AVERAGE 40
   unsigned long t=micros();
   unsigned long oneS=(t-ppsLastMicroS);
   if ((oneS > 1000000-20000) && (oneS < 1000000+20000)) {
-    ppsAvgMicroS=(ppsAvgMicroS*(NUM_SECS_TO_AVERAGE-1)+oneS)/NUM_SECS_TO_AVERAGE;
+    ppsIntervalMicroS=oneS;
+    ppsLst=lst;
+    ppsLstMicroS=t-lstMicroS;
+    ppsSamples++;
     ppsSynced=true;
   } else ppsSynced=false;
   ppsLastMicroS=t;
 }
+
+// PPS clock discipline, an FLL estimates the period of one second in micros() and a PLL steers the sidereal clock
+// phase, as captured at each PPS edge, back to the PPS with small rate limited corrections, if the PPS is lost the
+// last period estimate is held
+enum PpsState {PPS_NONE, PPS_ACQUIRING, PPS_LOCKED, PPS_HOLDOVER};
+PpsState ppsState       = PPS_NONE;
+double ppsPeriod        = 1000000.0;                         // estimated micros() per second
+double ppsCorrection    = 0.0;                               // phase correction in micros() per second, + slows the clock
+double ppsPhase         = 0.0;                               // sidereal clock phase error in micros(), + when ahead
+double ppsPhaseRms      = 0.0;
+long ppsCount           = 0;                                 // samples since acquisition started
+unsigned long ppsLastSample = 0;
+long ppsLastLst         = 0;
+unsigned long ppsLastLstMicroS = 0;
+
+// called once a second from loop2(), updates ppsRateRatio
+void ppsDiscipline() {
+  cli(); unsigned long samples=ppsSamples; unsigned long oneS=ppsIntervalMicroS; bool synced=ppsSynced; long cs=ppsLst; unsigned long us=ppsLstMicroS; sei();
+
+  if (!synced) {
+    if (ppsState == PPS_ACQUIRING || ppsState == PPS_LOCKED) { ppsState=PPS_HOLDOVER; ppsCorrection=0.0; ppsPhase=0.0; }
+  } else if (samples != ppsLastSample) {
+    // starts with the plain average of PPS_FLL_ACQUIRE samples, after a holdover the period estimate is kept
+    if (ppsState == PPS_NONE) { ppsPeriod=oneS; ppsCount=0; ppsState=PPS_ACQUIRING; }
+    if (ppsState == PPS_HOLDOVER) { ppsCount=PPS_FLL_ACQUIRE; ppsState=PPS_ACQUIRING; }
+
+    // phase error is how far the sidereal clock moved between PPS edges beyond 1.0027379 sidereal seconds per second,
+    // in solar micro-seconds (1 sidereal cs = 9972.695663 us,) the captured phase makes it a true phase measurement
+    double e=((double)(cs-ppsLastLst)-(double)(samples-ppsLastSample)*100.2737909)*9972.695663+((double)us-(double)ppsLastLstMicroS);
+    double f=(double)oneS-ppsPeriod;
+    ppsLastSample=samples; ppsLastLst=cs; ppsLastLstMicroS=us;
+
+    // an lst set (or a missed edge) shows up as a phase step, the period estimate isn't touched either
+    if (ppsState == PPS_LOCKED && (fabs(e) > PPS_OUTLIER || fabs(f) > PPS_OUTLIER)) return;
+
+    ppsCount++;
+    long n=ppsCount; if (n > PPS_FLL_TIME) n=PPS_FLL_TIME;
+    ppsPeriod+=f/n;
+
+    if (ppsState == PPS_ACQUIRING) {
+      if (ppsCount >= PPS_FLL_ACQUIRE) { ppsState=PPS_LOCKED; ppsPhase=0.0; ppsPhaseRms=0.0; }
+    } else {
+      ppsPhase+=e;
+      ppsCorrection=ppsPhase/PPS_PLL_TIME;
+      if (ppsCorrection >  PPS_PLL_SLEW_MAX) ppsCorrection= PPS_PLL_SLEW_MAX;
+      if (ppsCorrection < -PPS_PLL_SLEW_MAX) ppsCorrection=-PPS_PLL_SLEW_MAX;
+      ppsPhaseRms=sqrt(ppsPhaseRms*ppsPhaseRms*0.9+ppsPhase*ppsPhase*0.1);
+    }
+  }
+
+  // the sidereal clock is only reprogrammed once the rate has moved by PPS_RATE_STEP, not every second
+  double r=1000000.0/(ppsPeriod+ppsCorrection);
+  if (fabs(r-ppsRateRatio) >= PPS_RATE_STEP/1000000.0) { cli(); ppsRateRatio=r; sei(); }
+}
+
+// status as "s,f,p,r" where s is the state (0=no PPS, 1=acquiring, 2=locked, 3=holdover,) f the clock frequency
+// offset in ppm, p the phase error and r the RMS phase error in micro-seconds
+void ppsStatus(char *reply) {
+  char s1[12], s2[12], s3[12];
+  dtostrf(ppsPeriod-1000000.0,1,3,s1);
+  dtostrf(ppsPhase,1,1,s2);
+  dtostrf(ppsPhaseRms,1,1,s3);
+  sprintf(reply,"%d,%s,%s,%s",(int)ppsState,s1,s2,s3);
+}
 #endif
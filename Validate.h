@@ -146,6 +146,103 @@
   #define GUIDE_SPIRAL_TIME_LIMIT 103.4
 #endif
 
+// search pattern FOV in arc-seconds (0 for two seconds of travel at the guide rate,) overlap fraction, and raster rows
+#ifndef GUIDE_SEARCH_FOV
+  #define GUIDE_SEARCH_FOV 0.0
+#endif
+#ifndef GUIDE_SEARCH_OVERLAP
+  #define GUIDE_SEARCH_OVERLAP 0.2
+#endif
+#ifndef GUIDE_SEARCH_ROWS
+  #define GUIDE_SEARCH_ROWS 9
+#endif
+
+// longest pending pulse guide (in ms) that overlapping pulse guides on an axis can accumulate
+#ifndef GUIDE_PULSE_QUEUE_LIMIT
+  #define GUIDE_PULSE_QUEUE_LIMIT 16399
+#endif
+
+// guide offsets (:Mo/:MO) finish within this time (in ms) using a rate between these limits (x sidereal, below 10x so no acceleration is needed)
+#ifndef GUIDE_OFFSET_TIME_LIMIT
+  #define GUIDE_OFFSET_TIME_LIMIT 500
+#endif
+#ifndef GUIDE_OFFSET_RATE_MIN
+  #define GUIDE_OFFSET_RATE_MIN 0.5
+#endif
+#ifndef GUIDE_OFFSET_RATE_MAX
+  #define GUIDE_OFFSET_RATE_MAX 8.0
+#endif
+
+// closed loop guide controller is disabled by default, gains are in arc-seconds/second per arc-second of error
+#ifndef GUIDE_CONTROL
+  #define GUIDE_CONTROL OFF
+#endif
+#ifndef GUIDE_CONTROL_KP
+  #define GUIDE_CONTROL_KP 0.5
+#endif
+#ifndef GUIDE_CONTROL_KI
+  #define GUIDE_CONTROL_KI 0.05
+#endif
+#ifndef GUIDE_CONTROL_KD
+  #define GUIDE_CONTROL_KD 0.0
+#endif
+#ifndef GUIDE_CONTROL_KE
+  #define GUIDE_CONTROL_KE 0.7
+#endif
+#ifndef GUIDE_CONTROL_RATE_MAX
+  #define GUIDE_CONTROL_RATE_MAX 0.5
+#endif
+
+// tracking/guiding telemetry log is disabled by default
+#ifndef TELEMETRY_LOG
+  #define TELEMETRY_LOG OFF
+#endif
+// records sent per poll while dumping the telemetry log to a port that can't report room in its transmit buffer
+#ifndef TELEMETRY_DUMP_RECORDS
+  #define TELEMETRY_DUMP_RECORDS 2
+#endif
+
+// loop2() section profiler is enabled by default
+#ifndef PROFILER
+  #define PROFILER ON
+#endif
+
+// PPS clock discipline, FLL acquisition and averaging times in seconds, PLL time constant in seconds,
+// max phase correction and outlier rejection in micro-seconds per second
+#ifndef PPS_FLL_ACQUIRE
+  #define PPS_FLL_ACQUIRE 40
+#endif
+#ifndef PPS_FLL_TIME
+  #define PPS_FLL_TIME 300
+#endif
+#ifndef PPS_PLL_TIME
+  #define PPS_PLL_TIME 60.0
+#endif
+#ifndef PPS_PLL_SLEW_MAX
+  #define PPS_PLL_SLEW_MAX 10.0
+#endif
+#ifndef PPS_OUTLIER
+  #define PPS_OUTLIER 200.0
+#endif
+// smallest change in the sidereal clock rate (in ppm) that reprograms the timers
+#ifndef PPS_RATE_STEP
+  #define PPS_RATE_STEP 0.2
+#endif
+
+// external (SD card) object catalogs are disabled by default, the block cache is in 512 byte blocks
+#ifndef CATALOG_EXTERNAL
+  #define CATALOG_EXTERNAL OFF
+#endif
+#ifndef CATALOG_EXTERNAL_FILE
+  #define CATALOG_EXTERNAL_FILE "/CATALOG.BIN"
+#endif
+#ifndef CATALOG_EXTERNAL_CACHE
+  #define CATALOG_EXTERNAL_CACHE 4
+#endif
+#ifndef CATALOG_EXTERNAL_QUERY_LIMIT
+  #define CATALOG_EXTERNAL_QUERY_LIMIT 2000
+#endif
+
 // automatically set focuser/rotator step rate (or focuser DC pwm freq.) from AXISn_SLEW_RATE_DESIRED
 #ifndef AXIS3_STEP_RATE_MAX
   #define AXIS3_STEP_RATE_MAX (1000.0/(AXIS3_SLEW_RATE_DESIRED*AXIS3_STEPS_PER_DEGREE))
@@ -165,6 +262,20 @@
   #endif
 #endif
 
+// focuser velocity profiles
+#ifndef AXIS4_ACCEL_PROFILE
+  #define AXIS4_ACCEL_PROFILE TRAPEZOID
+#endif
+#ifndef AXIS4_ACCEL_TIME
+  #define AXIS4_ACCEL_TIME 250
+#endif
+#ifndef AXIS5_ACCEL_PROFILE
+  #define AXIS5_ACCEL_PROFILE TRAPEZOID
+#endif
+#ifndef AXIS5_ACCEL_TIME
+  #define AXIS5_ACCEL_TIME 250
+#endif
+
 // figure out how many align star are allowed for the configuration
 #if defined(MAX_NUM_ALIGN_STARS)
   #if MAX_NUM_ALIGN_STARS > '9' || MAX_NUM_ALIGN_STARS < '6'
@@ -187,6 +298,18 @@
 #ifndef MODE_SWITCH_SLEEP
   #define MODE_SWITCH_SLEEP OFF
 #endif
+#ifndef TMC_SPI_HARDWARE
+  #define TMC_SPI_HARDWARE ON
+#endif
+#ifndef GOTO_RATE_ADAPTIVE
+  #define GOTO_RATE_ADAPTIVE OFF
+#endif
+#ifndef GOTO_RATE_ADAPTIVE_SG_LOW
+  #define GOTO_RATE_ADAPTIVE_SG_LOW 100
+#endif
+#ifndef GOTO_RATE_ADAPTIVE_SG_HIGH
+  #define GOTO_RATE_ADAPTIVE_SG_HIGH 300
+#endif
 
 #ifndef AXIS1_DRIVER_ENABLE
   #define AXIS1_DRIVER_ENABLE LOW
@@ -864,6 +987,45 @@
   #error "Configuration (Config.h): Setting GUIDE_DISABLE_BACKLASH invalid, use OFF or ON only."
 #endif
 
+#if GUIDE_CONTROL != OFF && GUIDE_CONTROL != ON
+  #error "Configuration (Config.h): Setting GUIDE_CONTROL invalid, use OFF or ON only."
+#endif
+
+#if TELEMETRY_LOG != OFF && (TELEMETRY_LOG < 100 || TELEMETRY_LOG > 4000)
+  #error "Configuration (Config.h): Setting TELEMETRY_LOG invalid, use OFF or a number between 100 and 4000 (records.)"
+#endif
+#if TELEMETRY_LOG != OFF && defined(HAL_SERIAL_TRANSMIT)
+  #error "Configuration (Config.h): Setting TELEMETRY_LOG isn't supported on this platform, use OFF."
+#endif
+
+#if PROFILER != OFF && PROFILER != ON
+  #error "Configuration (Config.h): Setting PROFILER invalid, use OFF or ON only."
+#endif
+
+#if TMC_SPI_HARDWARE != OFF && TMC_SPI_HARDWARE != ON
+  #error "Configuration (Config.h): Setting TMC_SPI_HARDWARE invalid, use OFF or ON only."
+#endif
+
+#if GOTO_RATE_ADAPTIVE != OFF && GOTO_RATE_ADAPTIVE != ON
+  #error "Configuration (Config.h): Setting GOTO_RATE_ADAPTIVE invalid, use OFF or ON only."
+#endif
+#if GOTO_RATE_ADAPTIVE == ON && (AXIS1_DRIVER_STATUS != TMC_SPI || AXIS2_DRIVER_STATUS != TMC_SPI)
+  #error "Configuration (Config.h): Setting GOTO_RATE_ADAPTIVE requires AXIS1_DRIVER_STATUS and AXIS2_DRIVER_STATUS TMC_SPI."
+#endif
+#if GOTO_RATE_ADAPTIVE_SG_LOW < 0 || GOTO_RATE_ADAPTIVE_SG_LOW >= GOTO_RATE_ADAPTIVE_SG_HIGH || GOTO_RATE_ADAPTIVE_SG_HIGH > 1023
+  #error "Configuration (Config.h): Settings GOTO_RATE_ADAPTIVE_SG_LOW/HIGH invalid, use 0 <= LOW < HIGH <= 1023."
+#endif
+
+#if CATALOG_EXTERNAL != OFF && (CATALOG_EXTERNAL < 0 || CATALOG_EXTERNAL > 255)
+  #error "Configuration (Config.h): Setting CATALOG_EXTERNAL invalid, use OFF or a valid SD card CS pin."
+#endif
+#if CATALOG_EXTERNAL != OFF && defined(HAL_SLOW_PROCESSOR)
+  #error "Configuration (Config.h): Setting CATALOG_EXTERNAL isn't supported on this platform, use OFF."
+#endif
+#if CATALOG_EXTERNAL_CACHE < 1 || CATALOG_EXTERNAL_CACHE > 64
+  #error "Configuration (Config.h): Setting CATALOG_EXTERNAL_CACHE invalid, use a number between 1 and 64 (blocks.)"
+#endif
+
 #ifndef TRACK_AUTOSTART
   #error "Configuration (Config.h): Setting TRACK_AUTOSTART must be present!"
 #elif TRACK_AUTOSTART != OFF && TRACK_AUTOSTART != ON
@@ -1026,6 +1188,14 @@
   #error "Configuration (Config.h): Setting AXIS4_LIMIT_MAX invalid, use a number between 0 and 500 (mm) but > AXIS4_LIMIT_MIN."
 #endif
 
+#if AXIS4_ACCEL_PROFILE != OFF && AXIS4_ACCEL_PROFILE != TRAPEZOID && AXIS4_ACCEL_PROFILE != S_CURVE
+  #error "Configuration (Config.h): Setting AXIS4_ACCEL_PROFILE invalid, use OFF, TRAPEZOID, or S_CURVE only."
+#endif
+
+#if AXIS4_ACCEL_TIME < 10 || AXIS4_ACCEL_TIME > 5000
+  #error "Configuration (Config.h): Setting AXIS4_ACCEL_TIME invalid, use a number between 10 and 5000 (milli-seconds.)"
+#endif
+
 #if !defined(AXIS5_SLEW_RATE_DESIRED) && !defined(AXIS5_STEP_RATE_MAX)
   #error "Configuration (Config.h): Setting AXIS5_SLEW_RATE_DESIRED must be present!"
 #elif defined(AXIS5_SLEW_RATE_DESIRED) && AXIS5_DRIVER_DC_MODE == OFF && (AXIS5_SLEW_RATE_DESIRED < 200 || AXIS5_SLEW_RATE_DESIRED > 5000) 
@@ -1054,6 +1224,14 @@
   #error "Configuration (Config.h): Setting AXIS5_LIMIT_MAX invalid, use a number between 0 and 500 (mm) but > AXIS5_LIMIT_MIN."
 #endif
 
+#if AXIS5_ACCEL_PROFILE != OFF && AXIS5_ACCEL_PROFILE != TRAPEZOID && AXIS5_ACCEL_PROFILE != S_CURVE
+  #error "Configuration (Config.h): Setting AXIS5_ACCEL_PROFILE invalid, use OFF, TRAPEZOID, or S_CURVE only."
+#endif
+
+#if AXIS5_ACCEL_TIME < 10 || AXIS5_ACCEL_TIME > 5000
+  #error "Configuration (Config.h): Setting AXIS5_ACCEL_TIME invalid, use a number between 10 and 5000 (milli-seconds.)"
+#endif
+
 // -----------------------------------------------------------------------------------
 // -----------------------------------------------------------------------------------
 // stepper driver mode setup validation
@@ -1130,6 +1308,9 @@
   #if AXIS1_DRIVER_DECAY_MODE_GOTO == STEALTHCHOP || AXIS2_DRIVER_DECAY_MODE_GOTO == STEALTHCHOP
     #warning "Configuration (Config.h): TMC stepper driver _VQUIET mode is generally not recommended except for situations where motor RPM is low."
   #endif
+  #if GOTO_RATE_ADAPTIVE == ON && (AXIS1_DRIVER_DECAY_MODE_GOTO == STEALTHCHOP || AXIS2_DRIVER_DECAY_MODE_GOTO == STEALTHCHOP)
+    #error "Configuration (Config.h): Setting GOTO_RATE_ADAPTIVE requires spreadCycle during gotos, stallGuard doesn't work in stealthChop."
+  #endif
 
   // for stepper drivers where AXISn_MICROSTEPS_GOTO must be defined
   #if MODE_SWITCH_BEFORE_SLEW == ON && AXIS1_DRIVER_MICROSTEPS != OFF && AXIS1_DRIVER_MICROSTEPS_GOTO == OFF
@@ -1205,6 +1386,37 @@
   #endif
 #endif
 
+// the auxiliary timer takes over the PWM on some pins for some HAL's
+#if defined(HAL_AUX_TIMER_PWM_PIN) && (ROTATOR == ON || FOCUSER1 == ON || FOCUSER2 == ON || defined(DS1820_DEVICES_PRESENT))
+  #if LED_RETICLE != OFF && HAL_AUX_TIMER_PWM_PIN(ReticlePin)
+    #error "Configuration (Config.h): LED_RETICLE must be OFF while the focusers, rotator, or DS1820 use the auxiliary timer, the ReticlePin PWM is lost."
+  #endif
+  #if FEATURE1_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE1_PIN)
+    #error "Configuration (Config.h): FEATURE1_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE2_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE2_PIN)
+    #error "Configuration (Config.h): FEATURE2_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE3_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE3_PIN)
+    #error "Configuration (Config.h): FEATURE3_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE4_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE4_PIN)
+    #error "Configuration (Config.h): FEATURE4_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE5_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE5_PIN)
+    #error "Configuration (Config.h): FEATURE5_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE6_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE6_PIN)
+    #error "Configuration (Config.h): FEATURE6_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE7_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE7_PIN)
+    #error "Configuration (Config.h): FEATURE7_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+  #if FEATURE8_PURPOSE == ANALOG_OUT && HAL_AUX_TIMER_PWM_PIN(FEATURE8_PIN)
+    #error "Configuration (Config.h): FEATURE8_PIN can't be an ANALOG_OUT on this pin while the focusers, rotator, or DS1820 use the auxiliary timer."
+  #endif
+#endif
+
 // -----------------------------------------------------------------------------------
 // -----------------------------------------------------------------------------------
 // Validate pinmaps
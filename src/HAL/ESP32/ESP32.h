@@ -158,6 +158,29 @@ void Timer1SetInterval(long iv, double rateRatio) {
   timerAlarmWrite(itimer1, iv, true);
 }
 
+//--------------------------------------------------------------------------------------------------
+// Auxiliary timer for the rotator/focuser step generator
+
+#define HAL_AUX_TIMER
+#define HAL_AUX_TIMER_MICROS 50L
+
+hw_timer_t * itimer2 = NULL;
+void (*auxTimerCallback)() = NULL;
+
+IRAM_ATTR void auxTimerISR() {
+  portENTER_CRITICAL_ISR(&motorTimerMux);
+  (*auxTimerCallback)();
+  portEXIT_CRITICAL_ISR(&motorTimerMux);
+}
+
+void HAL_Init_Timer_Aux(void (*isr)()) {
+  auxTimerCallback=isr;
+  itimer2 = timerBegin(0, 80, true);  // 80/80 = 1 MHz
+  timerAttachInterrupt(itimer2, &auxTimerISR, true);
+  timerAlarmWrite(itimer2, HAL_AUX_TIMER_MICROS, true);
+  timerAlarmEnable(itimer2);
+}
+
 //--------------------------------------------------------------------------------------------------
 // Re-program interval for the motor timers
 
@@ -143,6 +143,32 @@ void Timer1SetInterval(long iv, double rateRatio) {
   TIMSK1 |= (1 << OCIE1A);
 }
 
+//--------------------------------------------------------------------------------------------------
+// Auxiliary timer for the rotator/focuser step generator, Timer5 in CTC mode at 2MHz
+
+#define HAL_AUX_TIMER
+#define HAL_AUX_TIMER_MICROS 200L
+#define HAL_AUX_TIMER_PWM_PIN(p) ((p) == 44 || (p) == 45 || (p) == 46) // analogWrite() doesn't work on these pins once Timer5 is taken
+
+void (*auxTimerCallback)() = NULL;
+
+void HAL_Init_Timer_Aux(void (*isr)()) {
+  auxTimerCallback=isr;
+  TCCR5A = 0;
+  TCCR5B = (1 << WGM52) | (1 << CS51);
+  OCR5A = HAL_AUX_TIMER_MICROS*2-1;
+  TIMSK5 = (1 << OCIE5A);
+}
+
+// the motor timers can interrupt the step generator, it masks itself so it can't be re-entered
+ISR(TIMER5_COMPA_vect) {
+  TIMSK5 = 0;
+  sei();
+  (*auxTimerCallback)();
+  cli();
+  TIMSK5 = (1 << OCIE5A);
+}
+
 //--------------------------------------------------------------------------------------------------
 // Re-program interval for the motor timers
 
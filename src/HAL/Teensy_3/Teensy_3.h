@@ -163,6 +163,19 @@ void Timer1SetInterval(long iv, double rateRatio) {
   itimer1.begin(TIMER1_COMPA_vect, (float)iv * 0.0625);
 }
 
+//--------------------------------------------------------------------------------------------------
+// Auxiliary timer for the rotator/focuser step generator, runs below the sidereal clock priority
+
+#define HAL_AUX_TIMER
+#define HAL_AUX_TIMER_MICROS 50L
+
+IntervalTimer itimer2;
+
+void HAL_Init_Timer_Aux(void (*isr)()) {
+  itimer2.begin(isr, (float)HAL_AUX_TIMER_MICROS);
+  itimer2.priority(64);
+}
+
 //--------------------------------------------------------------------------------------------------
 // Re-program interval for the motor timers
 
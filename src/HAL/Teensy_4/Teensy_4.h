@@ -109,6 +109,19 @@ void Timer1SetInterval(long iv, double rateRatio) {
   itimer1.priority(32);
 }
 
+//--------------------------------------------------------------------------------------------------
+// Auxiliary timer for the rotator/focuser step generator, runs below the sidereal clock priority
+
+#define HAL_AUX_TIMER
+#define HAL_AUX_TIMER_MICROS 50L
+
+static IntervalTimer itimer2;
+
+void HAL_Init_Timer_Aux(void (*isr)()) {
+  if (!itimer2.begin(isr, (float)HAL_AUX_TIMER_MICROS)) Serial.println("Error assigning timer2");
+  itimer2.priority(64);
+}
+
 //--------------------------------------------------------------------------------------------------
 // Re-program interval for the motor timers
 
@@ -79,6 +79,15 @@ void HAL_Init_Timers_Motor() {
 void Timer1SetInterval(long iv, double rateRatio) {
 }
 
+//--------------------------------------------------------------------------------------------------
+// Optional auxiliary timer for the rotator/focuser step generator, below the sidereal clock priority
+// without it the step generator is run from the main loop
+
+// #define HAL_AUX_TIMER
+// #define HAL_AUX_TIMER_MICROS 50L
+// void HAL_Init_Timer_Aux(void (*isr)()) {
+// }
+
 //--------------------------------------------------------------------------------------------------
 // Re-program interval for the motor timers
 
@@ -22,6 +22,12 @@ class nvs {
       return true;
     }
 
+    void flush() {
+    }
+
+    void preload(int i, int count) {
+    }
+
     byte read(int i) {
       return EEPROM.read(i);
     }
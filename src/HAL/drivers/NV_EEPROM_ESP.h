@@ -33,6 +33,19 @@ class nvs {
       return !_dirtyPool;
     }
 
+    // commit now, for critical data like the park position
+    void flush() {
+      if (_dirtyPool) {
+        timerAlarmsDisable();
+        EEPROM.commit();
+        timerAlarmsEnable();
+        _dirtyPool=false;
+      }
+    }
+
+    void preload(int i, int count) {
+    }
+
     byte read(int i) {
       return EEPROM.read(i);
     }
@@ -20,6 +20,20 @@
   #define EEPROM_WRITE_WAIT 10UL
 #endif
 
+// EEPROM page size in bytes, 32 for the AT24C32/64 or 64 for the AT24C128/256/512
+#if !defined(EEPROM_PAGE_SIZE)
+  #define EEPROM_PAGE_SIZE 32
+#endif
+
+// largest I2C transfer, must evenly divide the page size and (plus the two address bytes) fit in the Wire buffer
+#if !defined(EEPROM_BLOCK_SIZE)
+  #if defined(BUFFER_LENGTH) && BUFFER_LENGTH < EEPROM_PAGE_SIZE+2
+    #define EEPROM_BLOCK_SIZE 16
+  #else
+    #define EEPROM_BLOCK_SIZE EEPROM_PAGE_SIZE
+  #endif
+#endif
+
 #if !defined(E2END)
   #define E2END 4095
 #endif
@@ -45,69 +59,42 @@ class nvs {
       return !error;
     }
 
-    // move data to/from the cache
+    // move data to/from the cache, a block of dirty bytes is written as one I2C page write
     void poll() {
-      static int i=E2END;
-      uint8_t j;
-      int dirtyW, dirtyR;
+      static int b=0;
 
       // just exit if waiting for an EEPROM write to finish
       if (!ee_ready()) return;
 
-      // check 20 byte chunks of cache for data that needs processing so < about 2s to check the entire cache
-      for (int j=0; j < 20; j++) {
-        i++; if (i > E2END) i=0;
-        dirtyW=bitRead(cacheWriteState[i/8],i%8);
-        dirtyR=bitRead(cacheReadState[i/8],i%8);
-        if (dirtyW || dirtyR) break;
-      }
-
-      // write data as required
-      if (dirtyW) {
-        j=cache[i];        // get data from cache
-        ee_write(i,j);     // store in EEPROM
-        #ifdef NV_VALIDATE
-          uint8_t k;
-          ee_read(i,&k);
-          if (j!=k) {
-            //Serial.print("Write addr "); Serial.print(i); Serial.print(" value "); Serial.print(j); Serial.println(" FAILED");
-            //Serial.println("Restarting Wire");
-            HAL_Wire.end();
-            HAL_Wire.begin();
-            HAL_Wire.setClock(HAL_WIRE_CLOCK);
-            ee_write(i,j);
-            //ee_read(i,&k);
-            //if (j!=k) Serial.println("Second attempt FAILED"); else Serial.println("Second attempt SUCCESS");
-          }
-        #endif
-        bitWrite(cacheWriteState[i/8],i%8,0); // clean
-      } else {
-        // read data as required
-        if (dirtyR) {
-          ee_read(i,&j); // get data from EEPROM
-          cache[i]=j;      // store in cache
-          bitWrite(cacheReadState[i/8],i%8,0); // clean
-        }
+      // check 4 blocks of cache at a time for data that needs processing
+      for (int j=0; j < 4; j++) {
+        b++; if (b > E2END/EEPROM_BLOCK_SIZE) b=0;
+        if (commitBlock(b)) return;
+        if (fillBlock(b)) return;
       }
     }
 
     bool committed() {
-      int dirtyPool=0;
+      for (int j=0; j < CACHE_SIZE; j++) if (cacheWriteState[j]) return false;
+      return true;
+    }
 
-      // check 20 byte chunks of cache for data that needs processing so < about 2s to check the entire cache
-      for (int j=0; j < E2END; j++) {
-        dirtyPool=bitRead(cacheWriteState[j/8],j%8);
-        if (dirtyPool) break;
-      }
+    // write all dirty data to the EEPROM now, for critical data like the park position
+    void flush() {
+      for (int b=0; b <= E2END/EEPROM_BLOCK_SIZE; b++) commitBlock(b);
+    }
 
-      return !dirtyPool;
+    // bulk load count bytes starting at position i into the cache, one sequential read per block
+    void preload(int i, int count) {
+      int end=i+count-1; if (end > E2END) end=E2END;
+      for (int b=i/EEPROM_BLOCK_SIZE; b <= end/EEPROM_BLOCK_SIZE; b++) fillBlock(b);
     }
 
     uint8_t read(int i) {
       int dirty=bitRead(cacheReadState[i/8],i%8);
       if (dirty) {
         uint8_t j;
-        ee_read(i,&j);
+        ee_read(i,&j,1);
         
         // store and mark as clean
         cache[i]=j;
@@ -224,22 +211,79 @@ private:
   uint8_t cacheReadState[CACHE_SIZE];
   uint8_t cacheWriteState[CACHE_SIZE];
 
+  // write the dirty bytes in block b with a single page write, returns true if anything was written
+  bool commitBlock(int b) {
+    int start=b*EEPROM_BLOCK_SIZE;
+    int end=start+EEPROM_BLOCK_SIZE-1; if (end > E2END) end=E2END;
+
+    // quick check of the dirty bits, a block is at least 8 byte aligned
+    bool dirty=false;
+    for (int i=start/8; i <= end/8; i++) if (cacheWriteState[i]) { dirty=true; break; }
+    if (!dirty) return false;
+
+    int first=-1, last=-1;
+    for (int i=start; i <= end; i++) if (bitRead(cacheWriteState[i/8],i%8)) { if (first < 0) first=i; last=i; }
+
+    // clean bytes between the dirty ones are written back too, so they must be in the cache
+    for (int i=first; i <= last; i++) {
+      if (bitRead(cacheReadState[i/8],i%8)) {
+        uint8_t data[EEPROM_BLOCK_SIZE];
+        ee_read(first,data,last-first+1);
+        for (int k=first; k <= last; k++) {
+          if (bitRead(cacheReadState[k/8],k%8)) { cache[k]=data[k-first]; bitWrite(cacheReadState[k/8],k%8,0); }
+        }
+        break;
+      }
+    }
+
+    ee_write(first,&cache[first],last-first+1);
+    #ifdef NV_VALIDATE
+      uint8_t check[EEPROM_BLOCK_SIZE];
+      ee_read(first,check,last-first+1);
+      if (memcmp(check,&cache[first],last-first+1) != 0) {
+        HAL_Wire.end();
+        HAL_Wire.begin();
+        HAL_Wire.setClock(HAL_WIRE_CLOCK);
+        ee_write(first,&cache[first],last-first+1);
+      }
+    #endif
+    for (int i=first; i <= last; i++) bitWrite(cacheWriteState[i/8],i%8,0);
+    return true;
+  }
+
+  // read any bytes in block b that aren't in the cache yet, returns true if anything was read
+  bool fillBlock(int b) {
+    int start=b*EEPROM_BLOCK_SIZE;
+    int end=start+EEPROM_BLOCK_SIZE-1; if (end > E2END) end=E2END;
+
+    bool dirty=false;
+    for (int i=start/8; i <= end/8; i++) if (cacheReadState[i]) { dirty=true; break; }
+    if (!dirty) return false;
+
+    uint8_t data[EEPROM_BLOCK_SIZE];
+    ee_read(start,data,end-start+1);
+    for (int i=start; i <= end; i++) {
+      if (bitRead(cacheReadState[i/8],i%8)) { cache[i]=data[i-start]; bitWrite(cacheReadState[i/8],i%8,0); }
+    }
+    return true;
+  }
+
   bool ee_ready() {
     return (int32_t)(millis()-nextOpMs) >= 0;
   }
 
-  void ee_write(int offset, byte data) {
+  void ee_write(int offset, byte *data, byte count) {
     while (!ee_ready()) {}
     
     HAL_Wire.beginTransmission(_eeprom_addr);
     HAL_Wire.write(MSB(offset));
     HAL_Wire.write(LSB(offset));
-    HAL_Wire.write(data);
+    HAL_Wire.write(data,count);
     HAL_Wire.endTransmission();
     nextOpMs=millis()+EEPROM_WRITE_WAIT;
   }
 
-  void ee_read(int offset, byte *data) {
+  void ee_read(int offset, byte *data, byte count) {
     while (!ee_ready()) {}
     
     HAL_Wire.beginTransmission(_eeprom_addr);
@@ -247,9 +291,10 @@ private:
     HAL_Wire.write(LSB(offset));
     HAL_Wire.endTransmission();
 
-    HAL_Wire.requestFrom(_eeprom_addr, (uint8_t)1);
-    if (HAL_Wire.available()) {
-      *data = HAL_Wire.read();
+    HAL_Wire.requestFrom(_eeprom_addr, (uint8_t)count);
+    while (HAL_Wire.available()) {
+      *data = HAL_Wire.read(); data++;
+      count--; if (count == 0) break;
     }
   }
 };
@@ -40,6 +40,12 @@ class nvs {
       return true;
     }
 
+    void flush() {
+    }
+
+    void preload(int i, int count) {
+    }
+
     byte read(int i) {
       delayMicroseconds(FRAM_WRITE_WAIT);
       return fram.read8(i);
@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// Apparent place, converts J2000 (mean place) coordinates to and from apparent coordinates for the current date
+// precession (IAU 1976,) nutation (main terms of IAU 1980, about 0.5" accuracy,) and annual aberration are combined
+// into one rotation matrix and aberration vector that are cached and only refreshed as the date moves on
+
+#pragma once
+
+#define APPARENT_REFRESH_DAYS (5.0/1440.0)                   // refresh the cached matrix after five minutes
+
+double apparentMatrix[3][3]  = {{1.0,0.0,0.0},{0.0,1.0,0.0},{0.0,0.0,1.0}};
+double apparentAberration[3] = {0.0,0.0,0.0};               // Earth velocity/c in equatorial coordinates of date
+double apparentMatrixJD      = 0.0;
+
+// build the combined precession-nutation matrix and the aberration vector for Julian date jd
+void apparentUpdate(double jd) {
+  const double arcsec=1.0/(3600.0*Rad);
+  double T=(jd-2451545.0)/36525.0;
+
+  // precession angles
+  double zeta =(2306.2181+(0.30188+0.017998*T)*T)*T*arcsec;
+  double z    =(2306.2181+(1.09468+0.018203*T)*T)*T*arcsec;
+  double theta=(2004.3109-(0.42665+0.041833*T)*T)*T*arcsec;
+  double cZeta=cos(zeta), sZeta=sin(zeta), cZ=cos(z), sZ=sin(z), cTheta=cos(theta), sTheta=sin(theta);
+  double P[3][3]={{ cZeta*cZ*cTheta-sZeta*sZ, -sZeta*cZ*cTheta-cZeta*sZ, -cZ*sTheta},
+                  { cZeta*sZ*cTheta+sZeta*cZ, -sZeta*sZ*cTheta+cZeta*cZ, -sZ*sTheta},
+                  { cZeta*sTheta,             -sZeta*sTheta,              cTheta   }};
+
+  // nutation in longitude and obliquity
+  double O =(125.04452-1934.136261*T)/Rad;
+  double L =(280.4665+36000.7698*T)/Rad;
+  double Lm=(218.3165+481267.8813*T)/Rad;
+  double dPsi=(-17.20*sin(O)-1.32*sin(2.0*L)-0.23*sin(2.0*Lm)+0.21*sin(2.0*O))*arcsec;
+  double dEps=(  9.20*cos(O)+0.57*cos(2.0*L)+0.10*cos(2.0*Lm)-0.09*cos(2.0*O))*arcsec;
+  double eps0=(84381.448-46.8150*T)*arcsec;
+  double eps=eps0+dEps;
+  double cPsi=cos(dPsi), sPsi=sin(dPsi), cE0=cos(eps0), sE0=sin(eps0), cE=cos(eps), sE=sin(eps);
+  double N[3][3]={{ cPsi,     -sPsi*cE0,             -sPsi*sE0            },
+                  { sPsi*cE,   cPsi*cE*cE0+sE*sE0,    cPsi*cE*sE0-sE*cE0  },
+                  { sPsi*sE,   cPsi*sE*cE0-cE*sE0,    cPsi*sE*sE0+cE*cE0  }};
+
+  for (int i=0; i < 3; i++)
+    for (int j=0; j < 3; j++) apparentMatrix[i][j]=N[i][0]*P[0][j]+N[i][1]*P[1][j]+N[i][2]*P[2][j];
+
+  // annual aberration from the Sun's true longitude, the Earth moves toward ecliptic longitude sun-90 degrees
+  double M=(357.52911+35999.05029*T)/Rad;
+  double sun=(280.46646+36000.76983*T+(1.914602-0.004817*T)*sin(M)+0.019993*sin(2.0*M))/Rad;
+  double k=20.49552*arcsec;
+  apparentAberration[0]= k*sin(sun);
+  apparentAberration[1]=-k*cos(sun)*cE;
+  apparentAberration[2]=-k*cos(sun)*sE;
+
+  apparentMatrixJD=jd;
+}
+
+// the Julian date now, from the date and UT1
+double apparentJD() {
+  return JD+UT1_days+UT1/24.0;
+}
+
+// RA and Dec in degrees to a unit vector and back
+void apparentToVector(double RA, double Dec, double *v) {
+  double cDec=cos(Dec/Rad);
+  v[0]=cDec*cos(RA/Rad); v[1]=cDec*sin(RA/Rad); v[2]=sin(Dec/Rad);
+}
+
+void apparentFromVector(double *v, double *RA, double *Dec) {
+  double r=sqrt(v[0]*v[0]+v[1]*v[1]+v[2]*v[2]);
+  *Dec=asin(v[2]/r)*Rad;
+  *RA=atan2(v[1],v[0])*Rad; if (*RA < 0.0) *RA+=360.0;
+}
+
+// convert J2000 RA and Dec (in degrees) to apparent RA and Dec for the current date
+void j2000ToApparent(double *RA, double *Dec) {
+  double jd=apparentJD();
+  if (fabs(jd-apparentMatrixJD) > APPARENT_REFRESH_DAYS) apparentUpdate(jd);
+
+  double p[3], q[3];
+  apparentToVector(*RA,*Dec,p);
+  for (int i=0; i < 3; i++) q[i]=apparentMatrix[i][0]*p[0]+apparentMatrix[i][1]*p[1]+apparentMatrix[i][2]*p[2]+apparentAberration[i];
+  apparentFromVector(q,RA,Dec);
+}
+
+// convert apparent RA and Dec (in degrees) for the current date to J2000 RA and Dec
+void apparentToJ2000(double *RA, double *Dec) {
+  double jd=apparentJD();
+  if (fabs(jd-apparentMatrixJD) > APPARENT_REFRESH_DAYS) apparentUpdate(jd);
+
+  double p[3], q[3];
+  apparentToVector(*RA,*Dec,p);
+  for (int i=0; i < 3; i++) p[i]-=apparentAberration[i];
+  for (int i=0; i < 3; i++) q[i]=apparentMatrix[0][i]*p[0]+apparentMatrix[1][i]*p[1]+apparentMatrix[2][i]*p[2];
+  apparentFromVector(q,RA,Dec);
+}
@@ -0,0 +1,140 @@
+// -----------------------------------------------------------------------------------
+// Autofocus sequencer, steps the focuser through a V-curve, the client measures HFR (or FWHM) at each point
+// the best focus comes from a least squares fit of a hyperbola (a parabola in HFR^2) or a parabola in HFR
+// every point (and the final position) is approached moving outward so backlash is always taken up the same way
+
+#pragma once
+
+#define AUTOFOCUS_POINTS_MIN 5
+#define AUTOFOCUS_POINTS_MAX 15
+#define AUTOFOCUS_EXTEND 3                                   // points added once if the minimum is at an end of the curve
+
+enum AutofocusState {AF_IDLE, AF_MOVING, AF_MEASURE, AF_FINAL, AF_DONE, AF_FAILED};
+enum AutofocusFit {AF_HYPERBOLA, AF_PARABOLA};
+
+class autofocusSequencer {
+  public:
+    // starts a run on focuser f centered on its current position, step and positions in steps, returns false if busy or out of range
+    bool start(focuser *f, long step, int points, AutofocusFit fitType) {
+      if (busy() || f == NULL || step < 1 || points < AUTOFOCUS_POINTS_MIN || points > AUTOFOCUS_POINTS_MAX) return false;
+      long center=f->getPosition();
+      long first=center-step*((points-1)/2);
+      if (first-(step+f->getBacklash()) < f->getMin() || first+step*(points-1) > f->getMax()) return false;
+      foc=f; this->step=step; this->fitType=fitType;
+      startPos=center; planned=points; count=0; extended=false; failed=false; best=center; bestValue=0;
+      moveTo(first,AF_MOVING);
+      return state == AF_MOVING;
+    }
+
+    // the measurement for the position the focuser is at now, plans the next point or finishes the curve
+    bool measure(float value) {
+      if (state != AF_MEASURE || value <= 0.0 || count >= AUTOFOCUS_POINTS_MAX+AUTOFOCUS_EXTEND) return false;
+      pos[count]=target; hfr[count]=value; count++;
+
+      if (count < planned) { moveTo(target+step,AF_MOVING); return true; }
+
+      // extend the curve once if the lowest measurement is at an end of it
+      int low=0; for (int i=1; i < count; i++) if (hfr[i] < hfr[low]) low=i;
+      long lo=minPos(), hi=maxPos();
+      if (!extended && (pos[low] == lo || pos[low] == hi)) {
+        long p=(pos[low] == lo) ? lo-step*AUTOFOCUS_EXTEND : hi+step;
+        if (p-(step+foc->getBacklash()) >= foc->getMin() && p+step*(AUTOFOCUS_EXTEND-1) <= foc->getMax()) {
+          extended=true; planned=count+AUTOFOCUS_EXTEND; moveTo(p,AF_MOVING); return true;
+        }
+      }
+
+      if (fit()) moveTo(best,AF_FINAL); else { failed=true; moveTo(startPos,AF_FINAL); }
+      return true;
+    }
+
+    // stops the run and returns to the starting position
+    void abort() {
+      if (!busy()) return;
+      failed=true; moveTo(startPos,AF_FINAL);
+    }
+
+    // call periodically, waits for moves to finish
+    bool poll() {
+      if (state != AF_MOVING && state != AF_FINAL) return false;
+      if (foc->moving()) return true;
+      if (waypoint) { waypoint=false; if (!foc->setTarget(target)) state=AF_FAILED; return true; }
+      if (state == AF_FINAL) state=failed ? AF_FAILED : AF_DONE; else state=AF_MEASURE;
+      return true;
+    }
+
+    bool busy() { return state == AF_MOVING || state == AF_MEASURE || state == AF_FINAL; }
+
+    // status as "state,points measured,points planned,target position,best position,best value"
+    void status(char *reply, double spm) {
+      char bv[12]; dtostrf(bestValue,1,2,bv);
+      sprintf(reply,"%d,%d,%d,%ld,%ld,%s",(int)state,count,planned,(long)round(target/spm),(long)round(best/spm),bv);
+    }
+
+    // point i as "position,value"
+    bool point(int i, char *reply, double spm) {
+      if (i < 0 || i >= count) return false;
+      char v[12]; dtostrf(hfr[i],1,2,v);
+      sprintf(reply,"%ld,%s",(long)round(pos[i]/spm),v);
+      return true;
+    }
+
+  private:
+    // moves to p always finishing with an outward move, from below p by the backlash plus a step if needed
+    void moveTo(long p, AutofocusState s) {
+      target=p; state=s;
+      waypoint=p < foc->getPosition();
+      if (!foc->setTarget(waypoint ? p-(step+foc->getBacklash()) : p)) state=AF_FAILED;
+    }
+
+    long minPos() { long m=pos[0]; for (int i=1; i < count; i++) if (pos[i] < m) m=pos[i]; return m; }
+    long maxPos() { long m=pos[0]; for (int i=1; i < count; i++) if (pos[i] > m) m=pos[i]; return m; }
+
+    // least squares y=p0+p1*x+p2*x^2 where y is HFR^2 (hyperbola) or HFR (parabola), x relative to the start position
+    bool fit() {
+      double S[5]={0,0,0,0,0}, T[3]={0,0,0};
+      for (int i=0; i < count; i++) {
+        double x=(double)(pos[i]-startPos)/step;
+        double y=(fitType == AF_HYPERBOLA) ? hfr[i]*hfr[i] : hfr[i];
+        double xn=1.0;
+        for (int k=0; k < 5; k++) { S[k]+=xn; if (k < 3) T[k]+=xn*y; xn*=x; }
+      }
+      double A[3][4]={{S[0],S[1],S[2],T[0]},{S[1],S[2],S[3],T[1]},{S[2],S[3],S[4],T[2]}};
+      for (int c=0; c < 3; c++) {
+        int p=c; for (int r=c+1; r < 3; r++) if (fabs(A[r][c]) > fabs(A[p][c])) p=r;
+        if (fabs(A[p][c]) < 1e-9) return false;
+        if (p != c) for (int j=0; j < 4; j++) { double t=A[c][j]; A[c][j]=A[p][j]; A[p][j]=t; }
+        for (int r=c+1; r < 3; r++) { double f=A[r][c]/A[c][c]; for (int j=c; j < 4; j++) A[r][j]-=f*A[c][j]; }
+      }
+      double p2=A[2][3]/A[2][2];
+      double p1=(A[1][3]-A[1][2]*p2)/A[1][1];
+      double p0=(A[0][3]-A[0][1]*p1-A[0][2]*p2)/A[0][0];
+      if (p2 <= 0.0) return false;
+
+      // the vertex has to be within the measured range
+      double xc=-p1/(2.0*p2);
+      long c=startPos+lround(xc*step);
+      if (c < minPos() || c > maxPos()) return false;
+      double yc=p0-p1*p1/(4.0*p2);
+      if (fitType == AF_HYPERBOLA) bestValue=(yc > 0.0) ? sqrt(yc) : 0.0; else bestValue=yc;
+      best=c;
+      return true;
+    }
+
+    focuser *foc=NULL;
+    AutofocusState state=AF_IDLE;
+    AutofocusFit fitType=AF_HYPERBOLA;
+    long step=1;
+    long startPos=0;
+    long target=0;
+    bool waypoint=false;
+    bool failed=false;
+    bool extended=false;
+    int planned=0;
+    int count=0;
+    long pos[AUTOFOCUS_POINTS_MAX+AUTOFOCUS_EXTEND];
+    float hfr[AUTOFOCUS_POINTS_MAX+AUTOFOCUS_EXTEND];
+    long best=0;
+    double bestValue=0;
+};
+
+autofocusSequencer autofocus;
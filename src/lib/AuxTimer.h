@@ -0,0 +1,37 @@
+// -----------------------------------------------------------------------------------
+// Auxiliary timer, shares the HAL auxiliary timer between the step generator and the 1-Wire bus
+
+#pragma once
+
+#define AUX_TIMER_HOOKS 2
+
+IRAM_ATTR void auxTimerTick();
+
+class auxiliaryTimer {
+  public:
+    // adds a function to call every HAL_AUX_TIMER_MICROS, starts the timer on first use, returns false if full or there is no timer
+    bool attach(void (*hook)()) {
+#ifdef HAL_AUX_TIMER
+      if (hookCount >= AUX_TIMER_HOOKS) return false;
+      hooks[hookCount]=hook;
+      cli(); hookCount++; sei();
+      if (!started) { HAL_Init_Timer_Aux(auxTimerTick); started=true; }
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    IRAM_ATTR void tick() {
+      for (int i=0; i < hookCount; i++) (*hooks[i])();
+    }
+
+  private:
+    void (*hooks[AUX_TIMER_HOOKS])();
+    volatile int hookCount=0;
+    bool started=false;
+};
+
+auxiliaryTimer auxTimer;
+
+IRAM_ATTR void auxTimerTick() { auxTimer.tick(); }
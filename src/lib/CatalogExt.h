@@ -0,0 +1,191 @@
+// -----------------------------------------------------------------------------------
+// External object catalogs, read only from a file on SD card through a small block cache
+
+#pragma once
+
+#include <SPI.h>
+#include <SD.h>
+
+// file layout, all values are little endian:
+//   header     64 bytes, see catExtHeader_t
+//   catalogs   catalogCount catExtCatalog_t entries
+//   records    recordCount 16 byte libRec_t records with J2000 RA/Dec, grouped by catalog
+//   tiles      tileRa*tileDec+1 uint32_t entries, tile t holds tile list entries tiles[t]..tiles[t+1]-1
+//   tile list  uint32_t record numbers
+// tiles are equal RA by Dec cells where tile=decBand*tileRa+raCell and decBand 0 starts at Dec -90
+
+#define CAT_EXT_MAGIC       "OSCT"
+#define CAT_EXT_VERSION     1
+#define CAT_EXT_CATALOGS    8
+#define CAT_EXT_BLOCK_SIZE  512
+
+#pragma pack(1)
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t catalogCount;
+  uint32_t recordCount;
+  uint16_t tileRa;          // RA cells per Dec band
+  uint16_t tileDec;         // Dec bands
+  uint32_t catalogOffset;
+  uint32_t recordOffset;
+  uint32_t tileOffset;
+  uint32_t tileListOffset;
+  byte reserved[32];
+} catExtHeader_t;
+
+typedef struct {
+  char name[7];
+  byte number;              // catalog # this is served as, 0..14
+  uint32_t first;           // first record#
+  uint32_t count;           // number of records
+} catExtCatalog_t;
+#pragma pack()
+
+class catalogExt {
+  public:
+    // opens the catalog file on the SD card with chip select csPin, returns true if it's valid
+    bool init(int csPin) {
+      for (int i=0; i < CATALOG_EXTERNAL_CACHE; i++) { cacheBlock[i]=0xffffffff; cacheAge[i]=0; }
+      if (!SD.begin(csPin)) { DLF("ERR, catalogExt::init(): SD card not found"); return false; }
+      file=SD.open(CATALOG_EXTERNAL_FILE,FILE_READ);
+      if (!file) { DLF("ERR, catalogExt::init(): catalog file not found"); return false; }
+      size=file.size();
+
+      if (!read(0,&header,sizeof(catExtHeader_t)) || strncmp(header.magic,CAT_EXT_MAGIC,4) != 0 || header.version != CAT_EXT_VERSION ||
+          header.catalogCount > CAT_EXT_CATALOGS || header.tileRa == 0 || header.tileDec == 0) {
+        DLF("ERR, catalogExt::init(): catalog file format invalid"); file.close(); return false;
+      }
+      if (!read(header.catalogOffset,catalogs,header.catalogCount*sizeof(catExtCatalog_t))) { file.close(); return false; }
+      for (int i=0; i < header.catalogCount; i++) {
+        if (catalogs[i].number > 14 || catalogs[i].first+catalogs[i].count > header.recordCount) {
+          DLF("ERR, catalogExt::init(): catalog table invalid"); file.close(); return false;
+        }
+      }
+      ready=true;
+      return true;
+    }
+
+    // true if catalog # num is served from the file
+    bool has(int num) { return catalogIndex(num) >= 0; }
+
+    // number of records in catalog # num
+    long count(int num) {
+      int c=catalogIndex(num); if (c < 0) return 0;
+      return catalogs[c].count;
+    }
+
+    // read record i (0..count-1) of catalog # num
+    bool readRec(int num, long i, libRec_t *data) {
+      int c=catalogIndex(num); if (c < 0 || i < 0 || i >= (long)catalogs[c].count) return false;
+      return read(header.recordOffset+(catalogs[c].first+i)*rec_size,data,rec_size);
+    }
+
+    // find the records of catalog # num within radius (degrees) of RA,Dec (degrees) using the tile index, at most
+    // CATALOG_EXTERNAL_QUERY_LIMIT records are examined so the time taken is bounded, returns the number found
+    // results (if not NULL) gets up to maxResults record numbers (0..count-1) and nearest (if not NULL) the closest one
+    long withinRadius(int num, double RA, double Dec, double radius, long *results, int maxResults, long *nearest) {
+      int c=catalogIndex(num); if (c < 0) return 0;
+      uint32_t first=catalogs[c].first, last=catalogs[c].first+catalogs[c].count;
+      if (nearest != NULL) *nearest=-1;
+
+      double sinDec=sin(Dec/Rad), cosDec=cos(Dec/Rad);
+      double cosRadius=cos(radius/Rad);
+      double best=-2.0;
+      long found=0;
+      long examined=0;
+
+      double bandSize=180.0/header.tileDec;
+      double cellSize=360.0/header.tileRa;
+      int b0=floor((Dec-radius+90.0)/bandSize); if (b0 < 0) b0=0;
+      int b1=floor((Dec+radius+90.0)/bandSize); if (b1 >= header.tileDec) b1=header.tileDec-1;
+
+      // RA half-width of the search cap, all RA cells if it includes a pole
+      long cells=header.tileRa;
+      long c0=0;
+      if (fabs(Dec)+radius < 90.0) {
+        double dRA=asin(sin(radius/Rad)/cosDec)*Rad;
+        c0=floor((RA-dRA)/cellSize);
+        long c1=floor((RA+dRA)/cellSize);
+        if (c1-c0+1 < cells) cells=c1-c0+1;
+      }
+
+      for (int b=b0; b <= b1; b++) {
+        for (long k=0; k < cells; k++) {
+          long cell=(c0+k)%(long)header.tileRa; if (cell < 0) cell+=header.tileRa;
+          uint32_t t[2];
+          if (!read(header.tileOffset+((uint32_t)b*header.tileRa+cell)*4,t,8)) return found;
+
+          for (uint32_t e=t[0]; e < t[1]; e++) {
+            if (examined++ >= CATALOG_EXTERNAL_QUERY_LIMIT) return found;
+            uint32_t r;
+            if (!read(header.tileListOffset+e*4,&r,4)) return found;
+            if (r < first || r >= last) continue;
+
+            libRec_t work;
+            if (!read(header.recordOffset+r*rec_size,&work,rec_size)) return found;
+            double ra=((double)work.libRec.RA/65536.0)*360.0;
+            double dec=(((double)work.libRec.Dec/65536.0)*180.0)-90.0;
+            double d=sinDec*sin(dec/Rad)+cosDec*cos(dec/Rad)*cos((ra-RA)/Rad);
+            if (d < cosRadius) continue;
+
+            if (results != NULL && found < maxResults) results[found]=r-first;
+            found++;
+            if (nearest != NULL && d > best) { best=d; *nearest=r-first; }
+          }
+        }
+      }
+      return found;
+    }
+
+  private:
+    int catalogIndex(int num) {
+      if (!ready) return -1;
+      for (int i=0; i < header.catalogCount; i++) if (catalogs[i].number == num) return i;
+      return -1;
+    }
+
+    // read count bytes at offset through the block cache
+    bool read(uint32_t offset, void *data, int count) {
+      if (offset+count > size) return false;
+      byte *d=(byte*)data;
+      while (count > 0) {
+        uint32_t block=offset/CAT_EXT_BLOCK_SIZE;
+        int i=cacheFind(block); if (i < 0) return false;
+        int j=offset%CAT_EXT_BLOCK_SIZE;
+        int n=CAT_EXT_BLOCK_SIZE-j; if (n > count) n=count;
+        memcpy(d,&cache[i][j],n);
+        d+=n; offset+=n; count-=n;
+      }
+      return true;
+    }
+
+    // returns the cache slot holding this block, loading it into the least recently used slot if needed
+    int cacheFind(uint32_t block) {
+      int lru=0;
+      for (int i=0; i < CATALOG_EXTERNAL_CACHE; i++) {
+        if (cacheBlock[i] == block) { cacheAge[i]=++cacheClock; return i; }
+        if (cacheAge[i] < cacheAge[lru]) lru=i;
+      }
+      cacheBlock[lru]=0xffffffff;
+      if (!file.seek(block*CAT_EXT_BLOCK_SIZE)) return -1;
+      int n=file.read(cache[lru],CAT_EXT_BLOCK_SIZE);
+      if (n <= 0) return -1;
+      cacheBlock[lru]=block;
+      cacheAge[lru]=++cacheClock;
+      return lru;
+    }
+
+    bool ready=false;
+    File file;
+    uint32_t size=0;
+    catExtHeader_t header;
+    catExtCatalog_t catalogs[CAT_EXT_CATALOGS];
+
+    byte cache[CATALOG_EXTERNAL_CACHE][CAT_EXT_BLOCK_SIZE];
+    uint32_t cacheBlock[CATALOG_EXTERNAL_CACHE];
+    unsigned long cacheAge[CATALOG_EXTERNAL_CACHE];
+    unsigned long cacheClock=0;
+};
+
+catalogExt catExt;
@@ -0,0 +1,190 @@
+// -----------------------------------------------------------------------------------
+// Focus model, best focus samples from autofocus runs fitted to temperature, altitude, and filter slot
+// best focus = c0 + c1*dT + c2*dT^2 + c3*sin(alt) + filter offset, where dT is from the mean sample temperature
+// terms are only used once the samples span enough temperature (or altitude) to determine them
+
+#pragma once
+
+#define FOCUS_MODEL_SAMPLES 8
+#define FOCUS_MODEL_FILTERS 8
+#define FOCUS_MODEL_TERMS 4
+#define NV_FOCUS_MODEL_VERSION 1
+
+#pragma pack(1)
+typedef struct {
+  int16_t temperature;                                       // in 1/100 deg. C
+  int8_t altitude;                                           // in degrees
+  uint8_t filter;
+  int32_t position;                                          // best focus in steps
+} focusSample_t;
+
+typedef struct {
+  uint8_t enabled;                                           // temperature compensation uses the model
+  uint8_t count;
+  uint8_t next;                                              // the oldest sample is replaced once full
+  int8_t refAltitude;                                        // altitude and filter when compensation was enabled
+  uint8_t refFilter;
+  focusSample_t sample[FOCUS_MODEL_SAMPLES];
+} focusModelRecord_t;
+#pragma pack()
+
+class focusModel {
+  public:
+    // loads the samples from the NV record at slots a and b and fits the model
+    void init(int nvA, int nvB) {
+      this->nvA=nvA; this->nvB=nvB;
+      if (!nvRecordRead(nvA,nvB,NV_FOCUS_MODEL_VERSION,(byte*)&rec,sizeof(rec)) || rec.count > FOCUS_MODEL_SAMPLES || rec.next >= FOCUS_MODEL_SAMPLES) {
+        memset(&rec,0,sizeof(rec));
+      }
+      for (int i=0; i < rec.count; i++) if (rec.sample[i].filter >= FOCUS_MODEL_FILTERS) { memset(&rec,0,sizeof(rec)); break; }
+      if (rec.refFilter >= FOCUS_MODEL_FILTERS) rec.refFilter=0;
+      fit();
+    }
+
+    // adds a best focus sample, position in steps, and refits
+    bool add(float temperature, float altitude, int filter, long position) {
+      if (isnan(temperature) || temperature < -100.0 || temperature > 100.0) return false;
+      if (filter < 0 || filter >= FOCUS_MODEL_FILTERS) return false;
+      if (altitude < -90.0 || altitude > 90.0) return false;
+      focusSample_t *s=&rec.sample[rec.next];
+      s->temperature=lround(temperature*100.0);
+      s->altitude=lround(altitude);
+      s->filter=filter;
+      s->position=position;
+      rec.next=(rec.next+1)%FOCUS_MODEL_SAMPLES;
+      if (rec.count < FOCUS_MODEL_SAMPLES) rec.count++;
+      fit();
+      write();
+      return true;
+    }
+
+    void clear() { rec.count=0; rec.next=0; fit(); write(); }
+
+    // true if the model has a temperature or altitude term
+    bool valid() { return terms > 1; }
+
+    // predicted best focus in steps
+    double predict(float temperature, float altitude, int filter) {
+      double x[FOCUS_MODEL_TERMS];
+      basis(temperature,altitude,x);
+      double p=0;
+      for (int i=0; i < FOCUS_MODEL_TERMS; i++) if (use[i]) p+=coef[i]*x[i];
+      if (filter >= 0 && filter < FOCUS_MODEL_FILTERS) p+=filterOffset[filter];
+      return p;
+    }
+
+    void setEnabled(bool enabled) { rec.enabled=enabled; write(); }
+    bool isEnabled() { return rec.enabled; }
+
+    void setReference(float altitude, int filter) { rec.refAltitude=lround(altitude); rec.refFilter=filter; write(); }
+    float getRefAltitude() { return rec.refAltitude; }
+    int getRefFilter() { return rec.refFilter; }
+
+    int getCount() { return rec.count; }
+    int getTerms() { return terms; }
+    double getRms() { return rms; }
+
+    // sample i (0 is the oldest), returns false if there is no such sample
+    bool getSample(int i, float *temperature, float *altitude, int *filter, long *position) {
+      if (i < 0 || i >= rec.count) return false;
+      focusSample_t *s=&rec.sample[(rec.next+FOCUS_MODEL_SAMPLES-rec.count+i)%FOCUS_MODEL_SAMPLES];
+      *temperature=s->temperature/100.0; *altitude=s->altitude; *filter=s->filter; *position=s->position;
+      return true;
+    }
+
+  private:
+    void basis(float temperature, float altitude, double *x) {
+      double dT=temperature-tMean;
+      x[0]=1.0; x[1]=dT; x[2]=dT*dT; x[3]=sin(altitude/Rad);
+    }
+
+    // least squares fit of the terms the samples can determine, then the filter offsets from the residuals
+    void fit() {
+      int n=rec.count;
+      terms=0; rms=0;
+      for (int i=0; i < FOCUS_MODEL_TERMS; i++) { coef[i]=0; use[i]=false; }
+      for (int f=0; f < FOCUS_MODEL_FILTERS; f++) filterOffset[f]=0;
+      if (n < 1) return;
+
+      double tMin=1000, tMax=-1000, sMin=2, sMax=-2;
+      tMean=0;
+      for (int i=0; i < n; i++) {
+        double t=rec.sample[i].temperature/100.0, s=sin(rec.sample[i].altitude/Rad);
+        tMean+=t; if (t < tMin) tMin=t; if (t > tMax) tMax=t; if (s < sMin) sMin=s; if (s > sMax) sMax=s;
+      }
+      tMean/=n;
+      use[0]=true;
+      use[1]=n >= 2 && tMax-tMin >= 1.0;
+      use[2]=n >= 4 && tMax-tMin >= 5.0;
+      use[3]=n >= 4 && sMax-sMin >= 0.25;
+      for (int i=0; i < FOCUS_MODEL_TERMS; i++) if (use[i]) terms++;
+
+      // alternate between the base fit and the filter offsets, two passes are enough for this few samples
+      for (int pass=0; pass < 2; pass++) {
+        if (!solve(n)) { terms=0; return; }
+        double sum[FOCUS_MODEL_FILTERS]; int count[FOCUS_MODEL_FILTERS];
+        for (int f=0; f < FOCUS_MODEL_FILTERS; f++) { sum[f]=0; count[f]=0; }
+        for (int i=0; i < n; i++) {
+          focusSample_t *s=&rec.sample[i];
+          sum[s->filter]+=s->position-predict(s->temperature/100.0,s->altitude,s->filter);
+          count[s->filter]++;
+        }
+        for (int f=0; f < FOCUS_MODEL_FILTERS; f++) if (count[f] > 0) filterOffset[f]+=sum[f]/count[f];
+      }
+
+      for (int i=0; i < n; i++) {
+        focusSample_t *s=&rec.sample[i];
+        double r=s->position-predict(s->temperature/100.0,s->altitude,s->filter);
+        rms+=r*r;
+      }
+      rms=sqrt(rms/n);
+    }
+
+    // normal equations for the terms in use with positions less the filter offsets, Gaussian elimination
+    bool solve(int n) {
+      double A[FOCUS_MODEL_TERMS][FOCUS_MODEL_TERMS+1];
+      int idx[FOCUS_MODEL_TERMS], m=0;
+      for (int i=0; i < FOCUS_MODEL_TERMS; i++) if (use[i]) idx[m++]=i;
+      for (int r=0; r < m; r++) for (int c=0; c <= m; c++) A[r][c]=0;
+
+      for (int k=0; k < n; k++) {
+        focusSample_t *s=&rec.sample[k];
+        double x[FOCUS_MODEL_TERMS];
+        basis(s->temperature/100.0,s->altitude,x);
+        double y=s->position-filterOffset[s->filter];
+        for (int r=0; r < m; r++) {
+          for (int c=0; c < m; c++) A[r][c]+=x[idx[r]]*x[idx[c]];
+          A[r][m]+=x[idx[r]]*y;
+        }
+      }
+
+      for (int c=0; c < m; c++) {
+        int p=c;
+        for (int r=c+1; r < m; r++) if (fabs(A[r][c]) > fabs(A[p][c])) p=r;
+        if (fabs(A[p][c]) < 1e-9) return false;
+        if (p != c) for (int j=0; j <= m; j++) { double t=A[c][j]; A[c][j]=A[p][j]; A[p][j]=t; }
+        for (int r=c+1; r < m; r++) {
+          double f=A[r][c]/A[c][c];
+          for (int j=c; j <= m; j++) A[r][j]-=f*A[c][j];
+        }
+      }
+      for (int r=m-1; r >= 0; r--) {
+        double v=A[r][m];
+        for (int j=r+1; j < m; j++) v-=A[r][j]*coef[idx[j]];
+        coef[idx[r]]=v/A[r][r];
+      }
+      return true;
+    }
+
+    void write() { if (nvA >= 0) nvRecordWrite(nvA,nvB,NV_FOCUS_MODEL_VERSION,(byte*)&rec,sizeof(rec)); }
+
+    int nvA=-1;
+    int nvB=-1;
+    focusModelRecord_t rec={};
+    bool use[FOCUS_MODEL_TERMS]={false,false,false,false};
+    double coef[FOCUS_MODEL_TERMS];
+    double filterOffset[FOCUS_MODEL_FILTERS];
+    double tMean=0;
+    double rms=0;
+    int terms=0;
+};
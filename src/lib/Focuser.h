@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "FocusModel.h"
+
 // time to write position to nv after last movement of Focuser
 #if NV_ENDURANCE == VHIGH
   #define FOCUSER_WRITE_DELAY 1000L*5L       // 5 seconds
@@ -38,12 +40,36 @@ class focuser {
       if (tcf) {
         float tt = ambient.getTelescopeTemperature();
         if (isnan(tt)) { tcf=false; return 0; }
+        if (model.isEnabled() && model.valid()) {
+          // follow the focus model relative to the conditions when compensation was enabled, the deadband is hysteresis here
+          // only re-evaluated when the temperature, altitude, or filter has changed enough to matter
+          uint16_t changes = ambient.getTelescopeChanges();
+          if (tcfRefresh || changes != tcfChanges || fabs(currentAlt - tcfAlt) >= 0.5) {
+            tcfRefresh = false; tcfChanges = changes; tcfAlt = currentAlt;
+            long tc = lround(model.predict(tt,currentAlt,filter) - model.predict(tcf_t0,model.getRefAltitude(),model.getRefFilter()));
+            if (labs(tc - tcfApplied) >= tcf_deadband) tcfApplied = tc;
+          }
+          return tcfApplied;
+        }
         float tc = -round((tcf_coef * (tt - tcf_t0)) * spm);
         return lround(tc/(float)tcf_deadband)*(long)tcf_deadband;
       } else return 0;
     }
     virtual double getTcfT0() { return 0; }
 
+    // focus model, from best focus samples
+    void initFocusModel(int nvA, int nvB) { model.init(nvA,nvB); }
+    // temperature compensation by the focus model (or by the coefficient,) can't change while compensation is enabled
+    bool setTcfModel(bool enabled) { if (tcf) return false; model.setEnabled(enabled); return true; }
+    bool getTcfModel() { return model.isEnabled(); }
+    // filter slot 0..7 for the focus model
+    bool setFilter(int f) { if (f < 0 || f >= FOCUS_MODEL_FILTERS) return false; filter=f; tcfRefresh=true; return true; }
+    int getFilter() { return filter; }
+    // adds a sample at the current position and conditions, use when at best focus
+    bool addFocusSample() { if (moving()) return false; tcfRefresh=true; return model.add(ambient.getTelescopeTemperature(),currentAlt,filter,spos); }
+    void clearFocusSamples() { model.clear(); tcfRefresh=true; }
+    focusModel *getFocusModel() { return &model; }
+
     // get step size in microns
     virtual double getStepsPerMicro() { return spm; }
 
@@ -71,6 +97,9 @@ class focuser {
     // set movement rate in microns/second, from minRate to 1000
     virtual void setMoveRate(double rate) { }
 
+    // set velocity profile (OFF, TRAPEZOID, S_CURVE) and time to accelerate in milli-seconds for moves
+    virtual void setAccelProfile(int profile, int rampMs) { }
+
     // move in
     virtual void startMoveIn() { }
 
@@ -147,6 +176,12 @@ class focuser {
     double tcf_coef=0.0;
     double tcf_t0=10.0;
     double powerFor1mmSec=0.0;
+    focusModel model;
+    int filter=0;
+    long tcfApplied=0;
+    bool tcfRefresh=true;
+    uint16_t tcfChanges=0;
+    double tcfAlt=0;
 
     // position
     fixed_t target;
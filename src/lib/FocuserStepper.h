@@ -4,6 +4,7 @@
 #pragma once
 
 #include "Focuser.h"
+#include "StepGenerator.h"
 
 class focuserStepper : public focuser {
   public:
@@ -22,6 +23,7 @@ class focuserStepper : public focuser {
       
       pinMode(stepPin,OUTPUT);
       pinMode(dirPin,OUTPUT);
+      stepAxis=stepGen.attach(stepPin,dirPin,maxRate);
 
       // get the temperature compensated focusing settings
       float coef=nv.readFloat(nvAddress+EE_tcfCoef);
@@ -82,6 +84,8 @@ class focuserStepper : public focuser {
         if (enabled) {
           tcf_t0=ambient.getTelescopeTemperature();
           nv.writeFloat(nvAddress+EE_tcfT0,tcf_t0);
+          model.setReference(currentAlt,filter);
+          tcfApplied=0; tcfRefresh=true;
         } else {
           target.part.m=(long)target.part.m+getTcfSteps();
         }
@@ -101,6 +105,7 @@ class focuserStepper : public focuser {
     void setReverseState(int reverseState) {
       this->reverseState=reverseState;
       if (reverseState == LOW) forwardState=HIGH; else forwardState=LOW;
+      stepGen.setForwardState(stepAxis,forwardState);
     }
 
     // sets logic state for disabling stepper driver
@@ -125,6 +130,12 @@ class focuserStepper : public focuser {
       if (moveRate > spsMax) moveRate=spsMax;       // limit to maxRate
     }
 
+    // set velocity profile (OFF, TRAPEZOID, S_CURVE) and time to accelerate in milli-seconds for moves
+    void setAccelProfile(int profile, int rampMs) {
+      stepGen.setProfile(stepAxis,profile,rampMs);
+      stepGen.setRate(stepAxis,maxRate);
+    }
+
     // move in
     void startMoveIn() {
       if (!movementAllowed()) return;
@@ -140,7 +151,7 @@ class focuserStepper : public focuser {
     }
 
     // check if moving
-    bool moving() { if (delta.fixed != 0 || spos != (long)target.part.m) return true; else return false; }
+    bool moving() { if (delta.fixed != 0 || spos != targetSteps() || stepGen.busy(stepAxis)) return true; else return false; }
 
     // sets target position in steps
     bool setTarget(long pos) {
@@ -169,9 +180,14 @@ class focuserStepper : public focuser {
 
     void follow(bool mountSlewing) {
       if (!movementAllowed()) return;
+      stepGen.poll();
+
+      // account for the steps taken by the step generator
+      long steps=stepGen.collect(stepAxis);
+      if (steps != 0) { applySteps(steps); lastPhysicalMove=micros(); }
 
       // if enabled and the timeout has elapsed, disable the stepper driver
-      if (pda && !currentlyDisabled && ((long)(micros()-lastPhysicalMove) > FOCUSER_POWER_DOWN_DELAY*1000L)) { disableDriver(); currentlyDisabled=true; }
+      if (pda && !currentlyDisabled && !stepGen.busy(stepAxis) && ((long)(micros()-lastPhysicalMove) > FOCUSER_POWER_DOWN_DELAY*1000L)) { disableDriver(); currentlyDisabled=true; }
 
       unsigned long microsNow=micros();
       if ((long)(microsNow-nextPhysicalMove) > 0) {
@@ -186,36 +202,48 @@ class focuserStepper : public focuser {
         if (moving()) sinceMovingMs=millis();
         if (!mountSlewing && (long)(millis()-sinceMovingMs) > FOCUSER_WRITE_DELAY) writeTarget();
 
-        if ((spos < (long)target.part.m+getTcfSteps() && spos < smax) || backlashDir == BD_OUT) {
-          if (pda && currentlyDisabled) { enableDriver(); currentlyDisabled=false; delayMicroseconds(5); }
-          digitalWrite(stepPin,LOW); delayMicroseconds(5);
-          digitalWrite(dirPin,forwardState); delayMicroseconds(5);
-          digitalWrite(stepPin,HIGH);
-          if (backlashPos < backlash) { backlashPos++; backlashDir=BD_OUT; } else { spos++; backlashDir=BD_NONE; }
-          lastPhysicalMove=micros();
-        } else
-        if ((spos > (long)target.part.m+getTcfSteps() && spos > smin) || backlashDir == BD_IN) {
-          if (pda && currentlyDisabled) { enableDriver(); currentlyDisabled=false; delayMicroseconds(5); }
-          digitalWrite(stepPin,LOW); delayMicroseconds(5);
-          digitalWrite(dirPin,reverseState); delayMicroseconds(5);
-          digitalWrite(stepPin,HIGH);
-          if (backlashPos > 0) { backlashPos--; backlashDir=BD_IN; } else { spos--; backlashDir=BD_NONE; }
-          lastPhysicalMove=micros();
-        }
+        // steps to the target, any backlash take up is done first at the maximum rate, the driver gets one pass to wake up
+        long pos=targetSteps();
+        long need=0, preload=0;
+        if (pos > spos) { preload=backlash-backlashPos; need=preload+(pos-spos); } else
+        if (pos < spos) { preload=backlashPos; need=-(preload+(spos-pos)); }
+        if (need != 0 && pda && currentlyDisabled) { enableDriver(); currentlyDisabled=false; need=0; }
+        stepGen.request(stepAxis,need,preload);
       }
     }
 
   private:
 
+    // the position the motor is driven to, target plus temperature compensation within the limits
+    long targetSteps() {
+      long pos=(long)target.part.m+getTcfSteps();
+      if (pos < smin) pos=smin; if (pos > smax) pos=smax;
+      return pos;
+    }
+
+    // steps move through the backlash first then the position, as they did when stepped one at a time
+    void applySteps(long steps) {
+      if (steps > 0) {
+        long b=backlash-backlashPos; if (b < 0) b=0; if (b > steps) b=steps;
+        backlashPos+=b; spos+=steps-b;
+        if (b > 0 && backlashPos < backlash) backlashDir=BD_OUT; else backlashDir=BD_NONE;
+      } else {
+        long b=backlashPos; if (b > -steps) b=-steps;
+        backlashPos-=b; spos+=steps+b;
+        if (b > 0 && backlashPos > 0) backlashDir=BD_IN; else backlashDir=BD_NONE;
+      }
+    }
+
     void enableDriver() {
       if (enPin == OFF || enPin == SHARED) return;
-      digitalWrite(enPin,enableState); delayMicroseconds(20);
+      digitalWrite(enPin,enableState);
     }
 
     void disableDriver() {
       if (enPin == OFF || enPin == SHARED) return;
-      digitalWrite(enPin,disableState); delayMicroseconds(20);
+      digitalWrite(enPin,disableState);
     }
 
     bool startupOnly = false;
+    int stepAxis = -1;
 };
@@ -20,6 +20,10 @@ typedef union {
 } libRec_t;
 #pragma pack()
 
+#if CATALOG_EXTERNAL != OFF
+  #include "CatalogExt.h"
+#endif
+
 class Library
 {
   public:
@@ -53,17 +57,33 @@ class Library
     long recFreeAll();      // number records available for this library
     long recPos;            // currently selected record#
     long recMax;            // last record#
+
+    bool nearestRec(double RA, double Dec); // move to the record of this catalog nearest RA,Dec (in degrees)
     
   private:
     libRec_t readRec(long address);
+    void recCode(long address, int *cat, bool *name);
+    bool isCatalogRec(long address);
+    void indexRec(long address, libRec_t data);
+    void buildIndex();
     void writeRec(long address, libRec_t data);
     void clearRec(long address);
     inline double degRange(double d) { while (d >= 360.0) d-=360.0; while (d < 0.0)  d+=360.0; return d; }
 
     int catalog;
+    bool external;          // true if this catalog is read from the external catalog file
 
     long byteMin;
     long byteMax;
+
+    // in memory index built at init(), catIndex holds the catalog # (15=empty) of each record as a nibble and nameIndex flags
+    // catalog name records, if the allocation fails the library falls back to reading each record from NV
+    uint8_t *catIndex;
+    uint8_t *nameIndex;
+    long catCount[15];      // object records (excluding name records) in each catalog
+    long catFirst[15];      // lowest record# that ever held an object of each catalog
+    long catLast[15];       // highest record# that ever held an object of each catalog
+    long freeFirst;         // no empty records exist below this record#
 };
 
 Library Lib;
@@ -72,15 +92,19 @@ char const * objectStr[] = {"UNK", "OC", "GC", "PN", "DN", "SG", "EG", "IG", "KN
 Library::Library()
 {
   catalog=0;
+  external=false;
 
   byteMin=200+pecBufferSize;
-  byteMax=GSB;
+  byteMax=GSD-1;
 
   long byteCount=(byteMax-byteMin)+1;
   if (byteCount < 0) byteCount=0;
   if (byteCount > 262143) byteCount=262143; // maximum 256KB
 
   recMax=byteCount/rec_size; // maximum number of records
+
+  catIndex=NULL;
+  nameIndex=NULL;
 }
 
 Library::~Library()
@@ -91,19 +115,95 @@ void Library::init() {
   // This is now in the Init() function, because on boards
   // with an I2C EEPROM nv.init() has to be called before
   // anything else
+  buildIndex();
+#if CATALOG_EXTERNAL != OFF
+  if (catExt.init(CATALOG_EXTERNAL)) { VLF("MSG: Library, external catalog file ready"); }
+#endif
   firstRec();
 }
 
+// one pass over all records to build the index, navigation after this doesn't touch NV
+void Library::buildIndex()
+{
+  if (catIndex == NULL) catIndex=(uint8_t*)malloc((recMax+1)/2);
+  if (nameIndex == NULL) nameIndex=(uint8_t*)malloc((recMax+7)/8);
+  if (catIndex == NULL || nameIndex == NULL) {
+    if (catIndex != NULL) { free(catIndex); catIndex=NULL; }
+    if (nameIndex != NULL) { free(nameIndex); nameIndex=NULL; }
+    DLF("ERR, Library::buildIndex(): not enough memory, catalog index disabled");
+    return;
+  }
+
+  for (int c=0; c < 15; c++) { catCount[c]=0; catFirst[c]=recMax; catLast[c]=-1; }
+  freeFirst=recMax;
+
+  nv.preload(byteMin,recMax*rec_size);
+  for (long l=0; l < recMax; l++) {
+    libRec_t work=readRec(l);
+    int cat=(int)work.libRec.code>>4;
+    if (cat == 15 && l < freeFirst) freeFirst=l;
+    catIndex[l/2]=(l & 1) ? (catIndex[l/2] & 0x0f) | (cat<<4) : (catIndex[l/2] & 0xf0) | cat;
+    if (work.libRec.name[0] == '$') nameIndex[l/8]|=1<<(l & 7); else nameIndex[l/8]&=~(1<<(l & 7));
+    if (cat != 15 && work.libRec.name[0] != '$') { catCount[cat]++; if (l < catFirst[cat]) catFirst[cat]=l; if (l > catLast[cat]) catLast[cat]=l; }
+  }
+}
+
+// update the index for a record that was just written or cleared
+void Library::indexRec(long address, libRec_t data)
+{
+  if (catIndex == NULL) return;
+
+  int oldCat; bool oldName;
+  recCode(address,&oldCat,&oldName);
+  if (oldCat != 15 && !oldName) catCount[oldCat]--;
+
+  int cat=(int)data.libRec.code>>4;
+  bool name=data.libRec.name[0] == '$';
+  catIndex[address/2]=(address & 1) ? (catIndex[address/2] & 0x0f) | (cat<<4) : (catIndex[address/2] & 0xf0) | cat;
+  if (name) nameIndex[address/8]|=1<<(address & 7); else nameIndex[address/8]&=~(1<<(address & 7));
+  if (cat != 15 && !name) { catCount[cat]++; if (address < catFirst[cat]) catFirst[cat]=address; if (address > catLast[cat]) catLast[cat]=address; }
+
+  if (cat == 15) { if (address < freeFirst) freeFirst=address; } else if (address == freeFirst) {
+    while (freeFirst < recMax && (catIndex[freeFirst/2]>>((freeFirst & 1)*4) & 0x0f) != 15) freeFirst++;
+  }
+}
+
+// catalog # and name record flag for this record, from the index when available
+void Library::recCode(long address, int *cat, bool *name)
+{
+  if (catIndex != NULL) {
+    *cat=(catIndex[address/2]>>((address & 1)*4)) & 0x0f;
+    *name=(nameIndex[address/8]>>(address & 7)) & 1;
+  } else {
+    libRec_t work=readRec(address);
+    *cat=(int)work.libRec.code>>4;
+    *name=work.libRec.name[0] == '$';
+  }
+}
+
+// true if this record is an object of the current catalog
+bool Library::isCatalogRec(long address)
+{
+  int cat; bool name;
+  recCode(address,&cat,&name);
+  return !name && cat == catalog;
+}
+
 bool Library::setCatalog(int num)
 {
   if (num < 0 || num > 14) return false;
 
   catalog=num;
+#if CATALOG_EXTERNAL != OFF
+  external=catExt.has(num);
+#endif
   return firstRec();
 }
 
 void Library::writeVars(char* name, int code, double RA, double Dec)
 {
+  if (external) return;
+
   libRec_t work;
   for (int l=0; l < 11; l++) work.libRec.name[l] = name[l];
   work.libRec.code = (code | (catalog<<4));
@@ -124,6 +224,12 @@ void Library::writeVars(char* name, int code, double RA, double Dec)
 void Library::readVars(char* name, int* code, double* RA, double* Dec)
 {
   libRec_t work;
+#if CATALOG_EXTERNAL != OFF
+  if (external) {
+    if (!catExt.readRec(catalog,recPos,&work)) { name[0]=0; *code=0; *RA=0.0; *Dec=0.0; return; }
+    work.libRec.code=(work.libRec.code & 15) | (catalog<<4);
+  } else
+#endif
   work=readRec(recPos);
 
   int cat = work.libRec.code>>4;
@@ -142,6 +248,11 @@ void Library::readVars(char* name, int* code, double* RA, double* Dec)
   *RA=(*RA/65536.0)*360.0;
   *Dec=(double)d;
   *Dec=((*Dec/65536.0)*180.0)-90.0;
+
+#if TELESCOPE_COORDINATES != ASTROMETRIC_J2000
+  // external catalogs are J2000, everything else here works in apparent coordinates
+  if (external) j2000ToApparent(RA,Dec);
+#endif
 }
 
 libRec_t Library::readRec(long address)
@@ -155,6 +266,7 @@ libRec_t Library::readRec(long address)
 void Library::writeRec(long address, libRec_t data)
 {
   if (address >= 0 && address < recMax) {
+    indexRec(address,data);
     long l=address*rec_size+byteMin;
     for (int m=0; m < 16; m++) nv.write(l+m,data.libRecBytes[m]);
   }
@@ -165,19 +277,23 @@ void Library::clearRec(long address)
   if (address >= 0 && address < recMax) {
     long l=address*rec_size+byteMin;
     int code=15<<4;
+    if (catIndex != NULL) {
+      libRec_t work; int cat; bool name;
+      recCode(address,&cat,&name);
+      work.libRec.name[0]=name ? '$':0;
+      work.libRec.code=code;
+      indexRec(address,work);
+    }
     nv.write(l+11,(byte)code); // catalog code 15 = deleted
   }
 }
 
 bool Library::firstRec()
 {
-  libRec_t work;
-
   // see if first record is for the currentLib
   recPos=0;
-  work=readRec(recPos);
-  int cat=(int)work.libRec.code>>4;
-  if (work.libRec.name[0] != '$' && cat == catalog) return true;
+  if (external) return recCount() > 0;
+  if (recMax > 0 && isCatalogRec(recPos)) return true;
 
   // otherwise find the first one, if it exists
   return nextRec();
@@ -186,19 +302,17 @@ bool Library::firstRec()
 // move to the catalog name rec
 bool Library::nameRec()
 {
-  libRec_t work;
-
   int cat;
+  bool name;
   recPos=-1;
+  if (external) { recPos=0; return false; }
   
   do
   {
     recPos++; if (recPos >= recMax) break;
-    work=readRec(recPos);
-
-    cat=(int)work.libRec.code>>4;
+    recCode(recPos,&cat,&name);
 
-    if (work.libRec.name[0] == '$' && cat == catalog) break;
+    if (name && cat == catalog) break;
   } while (recPos < recMax);
   if (recPos >= recMax) { recPos=recMax-1; return false; }
 
@@ -208,17 +322,16 @@ bool Library::nameRec()
 // move to first unused record for this catalog
 bool Library::firstFreeRec()
 {
-  libRec_t work;
-
   int cat;
+  bool name;
   recPos=-1;
+  if (external) { recPos=0; return false; } // read only
+  if (catIndex != NULL) recPos=freeFirst-1;
   
   do
   {
     recPos++; if (recPos >= recMax) break;
-    work=readRec(recPos);
-
-    cat=(int)work.libRec.code>>4;
+    recCode(recPos,&cat,&name);
   
     if (cat == 15) break; // unused?
   } while (recPos < recMax);
@@ -230,19 +343,16 @@ bool Library::firstFreeRec()
 // read the previous record, if it exists
 bool Library::prevRec()
 {
-  libRec_t work;
+  long first=0;
+  if (external) { if (recPos <= 0) { recPos=0; return false; } recPos--; return true; }
+  if (catIndex != NULL) first=catFirst[catalog];
 
-  int cat;
-  
   do
   {
-    recPos--; if (recPos < 0) break;
-    work=readRec(recPos);
-
-    cat=(int)work.libRec.code>>4;
-    if (work.libRec.name[0] != '$' && cat == catalog) break;
-  } while (recPos >= 0);
-  if (recPos < 0) { recPos=0; return false; }
+    recPos--; if (recPos < first) break;
+    if (isCatalogRec(recPos)) break;
+  } while (recPos >= first);
+  if (recPos < first) { recPos=0; return false; }
 
   return true;
 }
@@ -250,19 +360,16 @@ bool Library::prevRec()
 // read the next record, if it exists
 bool Library::nextRec()
 {
-  libRec_t work;
-
-  int cat;
+  long last=recMax-1;
+  if (external) { long n=recCount(); if (recPos >= n-1) { recPos=n > 0 ? n-1:0; return false; } recPos++; return true; }
+  if (catIndex != NULL) last=catLast[catalog];
  
   do
   {
-    recPos++; if (recPos >= recMax) break;
-    work=readRec(recPos);
-
-    cat=(int)work.libRec.code>>4;
-    if (work.libRec.name[0] != '$' && cat == catalog) break;
-  } while (recPos < recMax);
-  if (recPos >= recMax) { recPos=recMax-1; return false; }
+    recPos++; if (recPos > last) break;
+    if (isCatalogRec(recPos)) break;
+  } while (recPos <= last);
+  if (recPos > last) { recPos=recMax-1; return false; }
 
   return true;
 }
@@ -270,17 +377,13 @@ bool Library::nextRec()
 // read the specified record (of this catalog), if it exists
 bool Library::gotoRec(long num)
 {
-  libRec_t work;
-
-  int cat;
   long r=0;
   long c=0;
+  if (external) { if (num < 1 || num > recCount()) return false; recPos=num-1; return true; }
   
   for (long l=0; l < recMax; l++) {
-    work=readRec(l); r=l;
-
-    cat=(int)work.libRec.code>>4;
-    if (work.libRec.name[0] != '$' && cat == catalog) c++;
+    r=l;
+    if (isCatalogRec(l)) c++;
     if (c == num) break;
   }
   if (c == num) { recPos=r; return true; } else return false;
@@ -289,17 +392,13 @@ bool Library::gotoRec(long num)
 // count all catalog records
 long Library::recCount()
 {
-  libRec_t work;
+#if CATALOG_EXTERNAL != OFF
+  if (external) return catExt.count(catalog);
+#endif
+  if (catIndex != NULL) return catCount[catalog];
 
-  int cat;
   long c=0;
-  
-  for (long l=0; l < recMax; l++) {
-    work=readRec(l);
-
-    cat=(int)work.libRec.code>>4;
-    if (work.libRec.name[0] != '$' && cat == catalog) c++;
-  }
+  for (long l=0; l < recMax; l++) if (isCatalogRec(l)) c++;
   
   return c;
 }
@@ -307,21 +406,56 @@ long Library::recCount()
 // count all library records (index or otherwise)
 long Library::recCountAll()
 {
-  libRec_t work;
-
   int cat;
+  bool name;
   long c=0;
   
   for (long l=0; l < recMax; l++) {
-    work=readRec(l);
-
-    cat=(int)work.libRec.code>>4;
+    recCode(l,&cat,&name);
     if (cat >= 0 && cat <= 14) c++;
   }
   
   return c;
 }
 
+// move to the record of this catalog nearest RA,Dec (in degrees), returns false if the catalog is empty
+bool Library::nearestRec(double RA, double Dec)
+{
+  long first=0, last=recMax-1;
+#if CATALOG_EXTERNAL != OFF
+  if (external) {
+    // widen the search until something turns up
+#if TELESCOPE_COORDINATES != ASTROMETRIC_J2000
+    apparentToJ2000(&RA,&Dec);
+#endif
+    long nearest=-1;
+    for (double radius=1.0; radius <= 256.0 && nearest < 0; radius*=4.0) catExt.withinRadius(catalog,RA,Dec,radius,NULL,0,&nearest);
+    if (nearest < 0) return false;
+    recPos=nearest;
+    return true;
+  }
+#endif
+  if (catIndex != NULL) { if (catCount[catalog] == 0) return false; first=catFirst[catalog]; last=catLast[catalog]; }
+
+  double sinDec=sin(Dec/Rad), cosDec=cos(Dec/Rad);
+  double best=-2.0;
+  long bestRec=-1;
+  for (long l=first; l <= last; l++) {
+    if (!isCatalogRec(l)) continue;
+    libRec_t work=readRec(l);
+
+    // cosine of the angular distance, largest is nearest
+    double r=((double)work.libRec.RA/65536.0)*360.0;
+    double d=(((double)work.libRec.Dec/65536.0)*180.0)-90.0;
+    double c=sinDec*sin(d/Rad)+cosDec*cos(d/Rad)*cos((r-RA)/Rad);
+    if (c > best) { best=c; bestRec=l; }
+  }
+  if (bestRec < 0) return false;
+
+  recPos=bestRec;
+  return true;
+}
+
 // library records available
 long Library::recFreeAll()
 {
@@ -331,27 +465,23 @@ long Library::recFreeAll()
 // mark this catalog record as empty
 void Library::clearCurrentRec()
 {
-  libRec_t work;
-
   int cat;
+  bool name;
+  if (external) return;
 
-  work=readRec(recPos);
-
-  cat=(int)work.libRec.code>>4;
+  recCode(recPos,&cat,&name);
   if (cat == catalog) clearRec(recPos);
 }
 
 // mark all catalog records as empty
 void Library::clearLib()
 {
-  libRec_t work;
-
   int cat;
+  bool name;
+  if (external) return;
 
   for (long l=0; l < recMax; l++) {
-    work=readRec(l);
-
-    cat=(int)work.libRec.code>>4;
+    recCode(l,&cat,&name);
     if (cat == catalog) clearRec(l);
   }
 }
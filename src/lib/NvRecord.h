@@ -0,0 +1,64 @@
+// -----------------------------------------------------------------------------------------------------------------------------
+// NV records, versioned and CRC protected with A/B slots so a power loss while writing never leaves a half written record
+
+// each slot holds: version (1 byte), sequence (1 byte), data (count bytes), CRC-16 (2 bytes) over all of the above
+#define NV_RECORD_OVERHEAD 4
+
+// CRC-16/CCITT
+uint16_t nvRecordCrc(uint16_t crc, const byte *d, int count) {
+  while (count-- > 0) {
+    crc^=(uint16_t)(*d++)<<8;
+    for (int i=0; i < 8; i++) { if (crc & 0x8000) crc=(crc<<1)^0x1021; else crc<<=1; }
+  }
+  return crc;
+}
+
+// check the slot at address i, returns true and its sequence number if valid
+bool nvRecordSlot(int i, byte version, int count, byte *sequence) {
+  byte header[2];
+  nv.readBytes(i,header,2);
+  if (header[0] != version) return false;
+  uint16_t crc=nvRecordCrc(0xFFFF,header,2);
+  for (int j=0; j < count; j++) { byte b=nv.read(i+2+j); crc=nvRecordCrc(crc,&b,1); }
+  if ((uint16_t)nv.readInt(i+2+count) != crc) return false;
+  *sequence=header[1];
+  return true;
+}
+
+// read the newest valid record from slots at addresses a and b, returns false if neither is valid
+bool nvRecordRead(int a, int b, byte version, byte *data, int count) {
+  byte seqA, seqB;
+  bool validA=nvRecordSlot(a,version,count,&seqA);
+  bool validB=nvRecordSlot(b,version,count,&seqB);
+  if (!validA && !validB) return false;
+  int i=a;
+  if (!validA || (validB && (int8_t)(seqB-seqA) > 0)) i=b;
+  for (int j=0; j < count; j++) data[j]=nv.read(i+2+j);
+  return true;
+}
+
+// write the record to the older (or invalid) of the slots at addresses a and b, the other slot keeps the last good copy
+void nvRecordWrite(int a, int b, byte version, byte *data, int count) {
+  byte seqA=0, seqB=0;
+  bool validA=nvRecordSlot(a,version,count,&seqA);
+  bool validB=nvRecordSlot(b,version,count,&seqB);
+  int i=a; byte sequence=seqB+1;
+  if (validA && (!validB || (int8_t)(seqA-seqB) > 0)) { i=b; sequence=seqA+1; }
+
+  // nothing to do if the newest record already holds this data
+  if (validA || validB) {
+    int newest=(i == a) ? b:a;
+    int j=0; while (j < count && nv.read(newest+2+j) == data[j]) j++;
+    if (j == count) return;
+  }
+
+  byte header[2]={version,sequence};
+  uint16_t crc=nvRecordCrc(0xFFFF,header,2);
+  crc=nvRecordCrc(crc,data,count);
+
+  // a partial write fails the CRC check so the record falls back to the other slot
+  nv.write(i,version);
+  nv.write(i+1,sequence);
+  for (int j=0; j < count; j++) nv.update(i+2+j,data[j]);
+  nv.writeInt(i+2+count,crc);
+}
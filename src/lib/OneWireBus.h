@@ -0,0 +1,174 @@
+// -----------------------------------------------------------------------------------
+// 1-Wire bus, runs the bit slots of a transaction from the auxiliary timer so it doesn't hold up the main loop
+// each tick does at most one slot, interrupts are only masked for the pin changes, the short write-1 and read slots
+// (about 10us,) and the presence sample, the long low of reset and write-0 slots tolerates being stretched by interrupts
+// so transactions continue while slewing
+// DS18B20/DS18S20 conversions and scratchpad reads use it, device searches and the DS2413 still use the OneWire library
+
+#pragma once
+
+#include "AuxTimer.h"
+
+#define OW_TICKS(us) (((us)+HAL_AUX_TIMER_MICROS-1L)/HAL_AUX_TIMER_MICROS)
+#define OW_SLOT_TICKS OW_TICKS(70L)                           // a time slot plus the recovery time
+#define OW_RESET_TICKS OW_TICKS(480L)                         // the reset pulse, and the presence wait after it
+#define OW_TX_MAX 10
+#define OW_RX_MAX 9
+
+#ifdef ESP32
+  // the auxiliary timer interrupt already holds the motor timer mux
+  #define OW_MASK
+  #define OW_UNMASK
+#else
+  #define OW_MASK noInterrupts()
+  #define OW_UNMASK interrupts()
+#endif
+
+enum OneWireBusState {OWB_IDLE, OWB_RESET, OWB_PRESENCE, OWB_SLOTS, OWB_DONE, OWB_FAILED};
+
+IRAM_ATTR void oneWireBusTick();
+
+class oneWireBus {
+  public:
+    // attaches to the auxiliary timer, returns false if it isn't available
+    bool init(int pin) {
+      this->pin=pin;
+#ifdef __AVR__
+      bitMask=digitalPinToBitMask(pin);
+      modeReg=portModeRegister(digitalPinToPort(pin));
+      outReg=portOutputRegister(digitalPinToPort(pin));
+      inReg=portInputRegister(digitalPinToPort(pin));
+      OW_MASK; *modeReg&=~bitMask; *outReg&=~bitMask; OW_UNMASK;
+#else
+      pinMode(pin,INPUT);
+#endif
+      ready=auxTimer.attach(oneWireBusTick);
+      return ready;
+    }
+
+    bool available() { return ready; }
+
+    // starts a transaction, a reset then txLen bytes written and rxLen bytes read, returns false if one is running
+    bool start(const uint8_t *txData, int txLen, int rxLen) {
+      if (!ready || busy() || txLen > OW_TX_MAX || rxLen > OW_RX_MAX) return false;
+      memcpy(tx,txData,txLen); for (int i=0; i < OW_RX_MAX; i++) rx[i]=0;
+      txBits=txLen*8; rxBits=rxLen*8; bit=0; wait=0;
+      state=OWB_RESET;
+      return true;
+    }
+
+    bool busy() { OneWireBusState s=state; return s != OWB_IDLE && s != OWB_DONE && s != OWB_FAILED; }
+
+    // starts a temperature conversion on all DS18B20/DS18S20 devices
+    bool convert() {
+      const uint8_t c[2]={0xCC,0x44};
+      return start(c,2,0);
+    }
+
+    // starts reading the scratchpad of the device at address
+    bool readScratchpad(const uint8_t *address) {
+      uint8_t c[10];
+      c[0]=0x55; memcpy(&c[1],address,8); c[9]=0xBE;
+      return start(c,10,9);
+    }
+
+    // temperature in deg. C from the scratchpad just read, DEVICE_DISCONNECTED_C if no device answered or the CRC is bad
+    float getTempC(const uint8_t *address) {
+      if (state != OWB_DONE) return DEVICE_DISCONNECTED_C;
+      uint8_t d[OW_RX_MAX];
+      bool allOnes=true; for (int i=0; i < 9; i++) { d[i]=rx[i]; if (d[i] != 0xFF) allOnes=false; }
+      if (allOnes || OneWire::crc8(d,8) != d[8]) return DEVICE_DISCONNECTED_C;
+      int16_t raw=(int16_t)(((uint16_t)d[1] << 8) | d[0]);
+      if (address[0] == 0x10) {
+        // DS18S20, 0.5 deg. C counts extended with the count remaining
+        if (d[7] == 0) return DEVICE_DISCONNECTED_C;
+        return (raw & 0xFFFE)/2.0-0.25+(float)(d[7]-d[6])/d[7];
+      }
+      // DS18B20, the low bits are undefined below 12 bit resolution
+      int resolution=9+((d[4] >> 5) & 3);
+      raw&=~((1 << (12-resolution))-1);
+      return raw/16.0;
+    }
+
+    // called every HAL_AUX_TIMER_MICROS
+    IRAM_ATTR void tick() {
+      OneWireBusState s=state;
+      if (s == OWB_IDLE || s == OWB_DONE || s == OWB_FAILED) return;
+      if (wait > 0) { wait--; return; }
+
+      if (s == OWB_RESET) {
+        OW_MASK; low(); OW_UNMASK;
+        wait=OW_RESET_TICKS-1; state=OWB_PRESENCE;
+      } else
+      if (s == OWB_PRESENCE) {
+        OW_MASK; release(); OW_UNMASK;
+        delayMicroseconds(70);
+        OW_MASK; bool present=!sense(); OW_UNMASK;
+        if (!present) { state=OWB_FAILED; return; }
+        wait=OW_RESET_TICKS-1;
+        state=(txBits+rxBits > 0) ? OWB_SLOTS : OWB_DONE;
+      } else
+      if (s == OWB_SLOTS) {
+        if (bit < txBits) {
+          bool b=(tx[bit >> 3] >> (bit & 7)) & 1;
+          if (b) { OW_MASK; low(); delayMicroseconds(6); release(); OW_UNMASK; } else {
+            // a write-0 low can run 60 to 120us so interrupts are left enabled for it
+            OW_MASK; low(); OW_UNMASK;
+            delayMicroseconds(60);
+            OW_MASK; release(); OW_UNMASK;
+          }
+        } else {
+          int r=bit-txBits;
+          OW_MASK; low(); delayMicroseconds(2); release(); delayMicroseconds(8); bool b=sense(); OW_UNMASK;
+          if (b) rx[r >> 3]|=(1 << (r & 7));
+        }
+        bit++;
+        if (bit >= txBits+rxBits) state=OWB_DONE; else wait=OW_SLOT_TICKS-1;
+      }
+    }
+
+  private:
+    // the bus is open drain, the pin is driven low or released to the pull-up
+    inline void low() {
+#ifdef __AVR__
+      // the OneWire library shares the pin and can leave the PORT bit set
+      *outReg&=~bitMask; *modeReg|=bitMask;
+#else
+      digitalWrite(pin,LOW); pinMode(pin,OUTPUT);
+#endif
+    }
+    inline void release() {
+#ifdef __AVR__
+      *modeReg&=~bitMask;
+#else
+      pinMode(pin,INPUT);
+#endif
+    }
+    inline bool sense() {
+#ifdef __AVR__
+      return (*inReg & bitMask) != 0;
+#else
+      return digitalRead(pin) == HIGH;
+#endif
+    }
+
+    int pin=-1;
+    bool ready=false;
+#ifdef __AVR__
+    uint8_t bitMask=0;
+    volatile uint8_t *modeReg=NULL;
+    volatile uint8_t *outReg=NULL;
+    volatile uint8_t *inReg=NULL;
+#endif
+    volatile OneWireBusState state=OWB_IDLE;
+    uint8_t tx[OW_TX_MAX];
+    volatile uint8_t rx[OW_RX_MAX];
+    int txBits=0;
+    int rxBits=0;
+    int bit=0;
+    int wait=0;
+};
+
+oneWireBus owBus;
+
+IRAM_ATTR void oneWireBusTick() { owBus.tick(); }
@@ -0,0 +1,64 @@
+// -----------------------------------------------------------------------------------
+// Profiler, run time of the main sections of loop2() in CPU cycles where a cycle counter is available
+
+#pragma once
+
+#if defined(ESP32)
+  #define PROFILER_TICKS() ((unsigned long)ESP.getCycleCount())
+  #define PROFILER_TICKS_PER_US (F_CPU/1000000UL)
+#elif defined(CORE_TEENSY) && defined(__arm__) && !defined(__MK20DX128__)
+  #define PROFILER_TICKS() ((unsigned long)ARM_DWT_CYCCNT)
+  #define PROFILER_TICKS_PER_US (F_CPU/1000000UL)
+#else
+  #define PROFILER_TICKS() micros()
+  #define PROFILER_TICKS_PER_US 1UL
+#endif
+
+enum ProfileSection {PS_ST4, PS_GUIDE, PS_PEC, PS_MOVETO, PS_ALT_CALC, PS_RATE_CALC, PS_WEATHER, PS_NV, PS_COMMANDS, PS_FOLLOW, PS_COUNT};
+const char * const profileSectionStr[PS_COUNT] = {"ST4", "guide", "pec", "moveTo", "doFastAltCalc", "doRateCalc", "ambient.poll", "nv.poll", "processCommands", "follow"};
+
+#if PROFILER == ON
+  #define PROFILE_START(s) unsigned long _profileStart##s=PROFILER_TICKS()
+  #define PROFILE_STOP(s) profiler.add(s,PROFILER_TICKS()-_profileStart##s)
+#else
+  #define PROFILE_START(s)
+  #define PROFILE_STOP(s)
+#endif
+
+class sectionProfiler {
+  public:
+    void init() {
+#if defined(CORE_TEENSY) && defined(__arm__) && !defined(__MK20DX128__)
+      // the Teensy3.x cycle counter isn't running by default
+      ARM_DEMCR|=ARM_DEMCR_TRCENA;
+      ARM_DWT_CTRL|=ARM_DWT_CTRL_CYCCNTENA;
+#endif
+      reset();
+    }
+
+    void reset() {
+      for (int i=0; i < PS_COUNT; i++) { count[i]=0; total[i]=0; worst[i]=0; }
+    }
+
+    void add(int section, unsigned long ticks) {
+      count[section]++;
+      total[section]+=ticks;
+      if (ticks > worst[section]) worst[section]=ticks;
+    }
+
+    // statistics for section n as "name,count,avg,worst,total" with times in micro-seconds, total in milli-seconds
+    bool status(int n, char *reply) {
+      if (n < 0 || n >= PS_COUNT) return false;
+      unsigned long avg=0;
+      if (count[n] > 0) avg=(unsigned long)((total[n]/count[n])/PROFILER_TICKS_PER_US);
+      sprintf(reply,"%s,%lu,%lu,%lu,%lu",profileSectionStr[n],count[n],avg,worst[n]/PROFILER_TICKS_PER_US,(unsigned long)(total[n]/(PROFILER_TICKS_PER_US*1000UL)));
+      return true;
+    }
+
+  private:
+    unsigned long count[PS_COUNT];
+    uint64_t total[PS_COUNT];
+    unsigned long worst[PS_COUNT];
+};
+
+sectionProfiler profiler;
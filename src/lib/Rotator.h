@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "StepGenerator.h"
+
 // time to write position to nv after last movement of Rotator
 #if NV_ENDURANCE == VHIGH
   #define ROTATOR_WRITE_DELAY 1000L*5L       // 5 seconds
@@ -12,6 +14,11 @@
   #define ROTATOR_WRITE_DELAY 1000L*60L*5L   // 5 minutes
 #endif
 
+#if MOUNT_TYPE == ALTAZM
+  #define DR_HA_TICK (15.0/360000.0/Rad)                     // hour angle change in radians per 1/100 sidereal second
+  #define DR_HA_RATE (15.0410686/3600.0)                     // hour angle change in degrees per second
+#endif
+
 class rotator {
   public:
     void init(int stepPin, int dirPin, int enPin, int nvAddress, float maxRate, double stepsPerDeg, double min, double max) {
@@ -28,6 +35,7 @@ class rotator {
 
       pinMode(stepPin,OUTPUT);
       pinMode(dirPin,OUTPUT);
+      stepAxis=stepGen.attach(stepPin,dirPin,maxRate);
 
       // get backlash amount
       int b=nv.readInt(nvAddress+EE_rotBacklash);
@@ -78,6 +86,7 @@ class rotator {
     void setReverseState(int reverseState) {
       this->reverseState=reverseState;
       if (reverseState == LOW) forwardState=HIGH; else forwardState=LOW;
+      stepGen.setForwardState(stepAxis,forwardState);
     }
 
     // sets logic state for disabling stepper driver
@@ -98,6 +107,7 @@ class rotator {
     // enable/disable the derotator
     void enableDR(bool state) {
       DR=state;
+      drValid=false;
     }
 
     // sets rotator to the parallactic angle in this area of the sky
@@ -143,7 +153,7 @@ class rotator {
     
     // check if moving
     bool moving() {
-      if (delta.fixed != 0 || (long)target.part.m != spos || backlashDir != BD_NONE) return true; else return false;
+      if (delta.fixed != 0 || (long)target.part.m != spos || backlashDir != BD_NONE || stepGen.busy(stepAxis)) return true; else return false;
     }
 
     // enable/disable new continuous move mode
@@ -203,30 +213,58 @@ class rotator {
       return true;
     }
 
-    // do derotate movement
+    // do derotate movement, called every 1/100 sidereal second
     void poll(bool tracking) {
       if (!movementAllowed()) return;
+#if MOUNT_TYPE == ALTAZM
+      if (DR && tracking && drValid) derotateTick();
+#endif
       if (DR && tracking) target.fixed+=deltaDR.fixed;
       target.fixed+=delta.fixed;
       if (((long)target.part.m < smin) || ((long)target.part.m > smax)) { DR=false; delta.fixed=0; deltaDR.fixed=0; }
     }
 
 #if MOUNT_TYPE == ALTAZM
-    // calculate new derotation rate if needed
+    // resynchronize the derotation model to the current hour angle and declination, poll() advances it each tick
     void derotate(double h, double d) {
-      if (DR) {
-        double pr=ParallacticRate(h,d)*spd;     // in steps per second
-        if (DRreverse) pr=-pr;
-        deltaDR.fixed=doubleToFixed(pr/100.0);  // in steps per 1/100 second
+      if (!DR) { drValid=false; return; }
+      drSinH=sin(h/Rad); drCosH=cos(h/Rad);
+      drSinD=sin(d/Rad); drCosD=cos(d/Rad);
+      drTanLat=tan(latitude/Rad);
+
+      // the fastest the rotator can follow in radians of field rotation per radian of hour angle, with some margin for the ramps
+      drLimit=((0.9*spsMax/spd)/DR_HA_RATE);
+
+      // near the zenith the field rotates faster than the rotator can follow, the rotation through the pass is spread
+      // over a window centered on the meridian so the rotator leads going in and lags coming out by the same amount
+      drWindowCos=2.0;
+      double x0=drCosD*drTanLat-drSinD;
+      if (fabs(x0)*drLimit < 1.0) {
+        double q0=ParallacticAngle(0.0,d);
+        double lo=0.0, hi=180.0/drLimit; if (hi > 180.0) hi=180.0;
+        for (int i=0; i < 16; i++) {
+          double t=(lo+hi)/2.0;
+          double dq=ParallacticAngle(t,d)-q0;
+          if (dq > 180.0) dq-=360.0; if (dq < -180.0) dq+=360.0;
+          if (fabs(dq) > drLimit*t) lo=t; else hi=t;
+        }
+        drWindowCos=cos(hi/Rad);
+        drWindowRate=(x0 < 0.0) ? -drLimit : drLimit;
       }
+      drValid=true;
     }
 #endif
     
     void follow(bool mountSlewing) {
       if (!movementAllowed()) return;
+      stepGen.poll();
+
+      // account for the steps taken by the step generator
+      long steps=stepGen.collect(stepAxis);
+      if (steps != 0) { applySteps(steps); lastPhysicalMove=micros(); }
 
       // if enabled and the timeout has elapsed, disable the stepper driver
-      if (pda && !currentlyDisabled && ((long)(micros()-lastPhysicalMove) > 10000000L)) { disableDriver(); currentlyDisabled=true; }
+      if (pda && !currentlyDisabled && !stepGen.busy(stepAxis) && ((long)(micros()-lastPhysicalMove) > 10000000L)) { disableDriver(); currentlyDisabled=true; }
 
       unsigned long microsNow=micros();
       if ((long)(microsNow-nextPhysicalMove) > 0) {
@@ -236,22 +274,13 @@ class rotator {
         if (moving()) sinceMovingMs=millis();
         if (!mountSlewing && !DR && (long)(millis()-sinceMovingMs) > ROTATOR_WRITE_DELAY) writeTarget();
 
-        if ((spos < (long)target.part.m && spos < smax) || backlashDir == BD_OUT) {
-          if (pda && currentlyDisabled) { currentlyDisabled=false; enableDriver(); delayMicroseconds(5); }
-          digitalWrite(stepPin,LOW); delayMicroseconds(5);
-          digitalWrite(dirPin,forwardState); delayMicroseconds(5);
-          digitalWrite(stepPin,HIGH);
-          if (backlashPos < backlash) { backlashPos++; backlashDir=BD_OUT; } else { spos++; backlashDir=BD_NONE; }
-          lastPhysicalMove=micros();
-        } else
-        if ((spos > (long)target.part.m && spos > smin) || backlashDir == BD_IN) {
-          if (pda && currentlyDisabled) { currentlyDisabled=false; enableDriver(); delayMicroseconds(5); }
-          digitalWrite(stepPin,LOW); delayMicroseconds(5);
-          digitalWrite(dirPin,reverseState); delayMicroseconds(5);
-          digitalWrite(stepPin,HIGH);
-          if (backlashPos > 0) { backlashPos--; backlashDir=BD_IN; } else { spos--; backlashDir=BD_NONE; }
-          lastPhysicalMove=micros();
-        }
+        // steps to the target including any backlash take up, the driver gets one pass to wake up
+        long pos=(long)target.part.m;
+        if (pos < smin) pos=smin; if (pos > smax) pos=smax;
+        long need=0;
+        if (pos > spos) need=(backlash-backlashPos)+(pos-spos); else if (pos < spos) need=-(backlashPos+(spos-pos));
+        if (need != 0 && pda && currentlyDisabled) { currentlyDisabled=false; enableDriver(); need=0; }
+        stepGen.request(stepAxis,need);
       }
     }
 
@@ -261,6 +290,19 @@ class rotator {
     bool movementAllowed() {
       if (enPin == SHARED && !axis1Enabled) return false; else return true;
     }
+    // steps move through the backlash first then the position, as they did when stepped one at a time
+    void applySteps(long steps) {
+      if (steps > 0) {
+        long b=backlash-backlashPos; if (b < 0) b=0; if (b > steps) b=steps;
+        backlashPos+=b; spos+=steps-b;
+        if (b > 0 && backlashPos < backlash) backlashDir=BD_OUT; else backlashDir=BD_NONE;
+      } else {
+        long b=backlashPos; if (b > -steps) b=-steps;
+        backlashPos-=b; spos+=steps+b;
+        if (b > 0 && backlashPos > 0) backlashDir=BD_IN; else backlashDir=BD_NONE;
+      }
+    }
+
     void writeTarget() {
       nv.writeLong(nvAddress+EE_rotSpos,spos);
       nv.writeInt(nvAddress+EE_rotBacklashPos,backlashPos);
@@ -291,23 +333,36 @@ class rotator {
       return atan2(sin(HA/Rad),cos(Dec/Rad)*tan(latitude/Rad)-sin(Dec/Rad)*cos(HA/Rad))*Rad;
     }
     
-    // returns parallactic rate in degrees per second
-    double ParallacticRate(double HA, double Dec) {
-      // one minute of HA in degrees=15/60=0.25
-      double a1=ParallacticAngle(HA-0.125,Dec);
-      double a2=ParallacticAngle(HA+0.125,Dec);
-      if ((a1 > +90.0) && (a2 < -90.0)) a2+=360.0;
-      if ((a1 < -90.0) && (a2 > +90.0)) a1+=360.0;
-      return (a2-a1)/60.0;
-    /*
-      double x=cos(Dec*Rad)*tan(latitude*Rad)-sin(Dec*Rad)*cos(HA*Rad);
-      double sin2H=sin(HA*Rad)*sin(HA*Rad);
-      return (0.25*(x*cos(HA*Rad)-sin2H*sin(Dec*Rad))/(x*x+sin2H))/60.0;
-    */
+    // field rotation for the next tick in steps, second order in the hour angle from the analytic rate and acceleration
+    // q=atan2(sin(H),x) where x=cos(Dec)*tan(Lat)-sin(Dec)*cos(H), dq/dH=N/D with N=x*cos(H)-sin^2(H)*sin(Dec) and D=x^2+sin^2(H)
+    void derotateTick() {
+      double s=drSinH, c=drCosH;
+      double q;
+      if (c > drWindowCos) q=drWindowRate*DR_HA_TICK; else {
+        double x=drCosD*drTanLat-drSinD*c;
+        double D=x*x+s*s;
+        double N=x*c-s*s*drSinD;
+        double Nd=-x*s-s*c*drSinD;
+        double Dd=2.0*s*(x*drSinD+c);
+        if (D < 1.0E-12) q=0.0; else {
+          double rate=N/D;
+          double accel=(Nd*D-N*Dd)/(D*D);
+          q=rate*DR_HA_TICK+0.5*accel*DR_HA_TICK*DR_HA_TICK;
+        }
+        if (q > drLimit*DR_HA_TICK) q=drLimit*DR_HA_TICK; else if (q < -drLimit*DR_HA_TICK) q=-drLimit*DR_HA_TICK;
+      }
+      double steps=q*Rad*spd;
+      if (DRreverse) steps=-steps;
+      deltaDR.fixed=doubleToFixed(steps);
+
+      // advance the hour angle by one tick
+      drSinH=s*drCosTick+c*drSinTick;
+      drCosH=c*drCosTick-s*drSinTick;
     }
 #endif
 
     // parameters
+    int stepAxis=-1;
     int stepPin=-1;
     int dirPin=-1;
     int enPin=-1;
@@ -345,6 +400,16 @@ class rotator {
     double moveRate=0.1;
     fixed_t delta;
     fixed_t deltaDR;
+#if MOUNT_TYPE == ALTAZM
+    bool drValid=false;
+    double drSinH=0, drCosH=1;
+    double drSinD=0, drCosD=1;
+    double drTanLat=0;
+    double drLimit=0;
+    double drWindowCos=2.0;
+    double drWindowRate=0;
+    double drSinTick=sin(DR_HA_TICK), drCosTick=cos(DR_HA_TICK);
+#endif
     double increment=1.0;
     
     // timing
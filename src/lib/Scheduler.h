@@ -0,0 +1,91 @@
+// -----------------------------------------------------------------------------------
+// Cooperative task scheduler, runs named tasks by priority when due and keeps run time statistics
+
+#pragma once
+
+#define TASKS_MAX 20
+#define TASK_SLOT_MICROS 10000L                              // lower priority work fits in the slack of this 1/100s slot
+#define TASK_WAIT_MAX 50000L                                 // period 0 tasks that waited this long run regardless of slack
+
+// returns false if there was nothing to do so idle calls don't count in the statistics
+typedef bool (*TaskCallback)();
+
+typedef struct {
+  const char *name;
+  TaskCallback callback;
+  unsigned long period;                                      // in micro-seconds, 0 runs on every pass
+  byte priority;                                             // 0 (highest) to 3, priority 0 tasks always run when due
+  unsigned long budget;                                      // expected worst case run time in micro-seconds
+  unsigned long next;                                        // next run, or the last run for period 0 tasks
+  bool running;
+  unsigned long count;
+  unsigned long maxTime;
+  unsigned long avgTime;
+  unsigned long overruns;                                    // runs that took longer than the budget
+} Task;
+
+class taskScheduler {
+  public:
+    // adds a task, tasks are kept in priority order (then in the order added,) returns false if the task table is full
+    bool add(const char *name, TaskCallback callback, unsigned long period, byte priority, unsigned long budget) {
+      if (taskCount >= TASKS_MAX) return false;
+      int i=taskCount;
+      while (i > 0 && task[i-1].priority > priority) { task[i]=task[i-1]; i--; }
+      task[i].name=name; task[i].callback=callback; task[i].period=period; task[i].priority=priority; task[i].budget=budget;
+      task[i].next=micros(); task[i].running=false;
+      task[i].count=0; task[i].maxTime=0; task[i].avgTime=0; task[i].overruns=0;
+      taskCount++;
+      return true;
+    }
+
+    // marks the start of a 1/100s slot, called by the task that runs on the sidereal tick
+    void slotStart() { slotMicros=micros(); }
+
+    // micro-seconds left in this slot
+    long slack() { return TASK_SLOT_MICROS-(long)(micros()-slotMicros); }
+
+    // runs all due tasks, lower priority tasks only start if their budget fits in the slack
+    // of this slot or if they've been waiting for longer than their period (TASK_WAIT_MAX for period 0 tasks)
+    void poll() {
+      for (int i=0; i < taskCount; i++) {
+        Task *t=&task[i];
+        if (t->running) continue; // loop2() is re-entered during extended processing
+        unsigned long now=micros();
+        long late=(long)(now-t->next);
+        if (t->period != 0 && late < 0) continue;
+        long wait=(t->period != 0) ? (long)t->period:TASK_WAIT_MAX;
+        if (t->priority > 0 && (long)t->budget > slack() && late < wait) continue;
+
+        t->running=true;
+        bool worked=(*t->callback)();
+        unsigned long runTime=micros()-now;
+        t->running=false;
+
+        if (t->period != 0) { t->next+=t->period; if ((long)(now-t->next) >= 0) t->next=now+t->period; } else t->next=now;
+        if (worked) {
+          t->count++;
+          if (runTime > t->maxTime) t->maxTime=runTime;
+          t->avgTime=(t->avgTime*15+runTime)/16;
+          if (runTime > t->budget) t->overruns++;
+        }
+      }
+    }
+
+    // statistics for task n as "name,count,avg,max,overruns" with times in micro-seconds
+    bool status(int n, char *reply) {
+      if (n < 0 || n >= taskCount) return false;
+      sprintf(reply,"%s,%lu,%lu,%lu,%lu",task[n].name,task[n].count,task[n].avgTime,task[n].maxTime,task[n].overruns);
+      return true;
+    }
+
+    void resetStatus() {
+      for (int i=0; i < taskCount; i++) { task[i].count=0; task[i].maxTime=0; task[i].avgTime=0; task[i].overruns=0; }
+    }
+
+  private:
+    Task task[TASKS_MAX];
+    int taskCount=0;
+    unsigned long slotMicros=0;
+};
+
+taskScheduler tasks;
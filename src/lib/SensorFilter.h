@@ -0,0 +1,60 @@
+// -----------------------------------------------------------------------------------
+// Sensor filter, smooths one channel of readings with an exponential filter that ignores isolated spikes
+// the reported value only follows the filtered value once it has changed by the threshold, users can watch the change count
+// a channel with no good reading for the stale time isn't fresh, so a fallback source can be used instead
+
+#pragma once
+
+#define SENSOR_FILTER_SPIKES 3                               // readings in a row this far out are accepted as a real change
+
+class sensorFilter {
+  public:
+    // tau is the time constant in seconds, threshold the change that's reported, spike the jump that's ignored unless repeated
+    void init(float tau, float threshold, float spike, unsigned long staleMs) {
+      this->tau=tau; this->threshold=threshold; this->spike=spike; this->staleMs=staleMs;
+    }
+
+    // adds a reading, NAN if the read failed
+    void update(float raw) {
+      unsigned long now=millis();
+      if (isnan(raw)) return;
+      held=false;
+      if (!valid) { filtered=raw; reported=raw; valid=true; changes++; lastMs=now; outliers=0; return; }
+
+      if (fabs(raw-filtered) > spike && ++outliers < SENSOR_FILTER_SPIKES) return;
+      if (outliers >= SENSOR_FILTER_SPIKES) filtered=raw; else {
+        float dt=(long)(now-lastMs)/1000.0; if (dt < 0.0) dt=0.0;
+        filtered+=(raw-filtered)*(dt/(tau+dt));
+      }
+      outliers=0;
+      lastMs=now;
+
+      if (fabs(filtered-reported) >= threshold) { reported=filtered; changes++; }
+    }
+
+    // sets the value directly, for values given by command, it doesn't go stale until a sensor reading replaces it
+    void set(float v) { filtered=v; reported=v; valid=true; held=true; outliers=0; lastMs=millis(); changes++; }
+
+    // true if the value was set or there was a good reading within the stale time
+    bool fresh() { return valid && (held || (long)(millis()-lastMs) <= (long)staleMs); }
+
+    float getFiltered() { return valid ? filtered : NAN; }
+    float getReported() { return valid ? reported : NAN; }
+
+    // counts changes of the reported value
+    uint16_t getChanges() { return changes; }
+
+  private:
+    float tau=20.0;
+    float threshold=0.1;
+    float spike=5.0;
+    unsigned long staleMs=30000;
+
+    bool valid=false;
+    bool held=false;
+    float filtered=0;
+    float reported=0;
+    byte outliers=0;
+    unsigned long lastMs=0;
+    uint16_t changes=0;
+};
@@ -1,16 +1,62 @@
 // -----------------------------------------------------------------------------------
 // Simple soft SPI routines (CPOL=1, CPHA=1)
+// if the pins are the hardware SPI port's pins (on the ESP32 whichever pins claimed the port first) the port is used
+// instead, a transaction from begin() to end() holds the port so several registers can be written with a pause() between them
 
 #pragma once
 
+#if TMC_SPI_HARDWARE == ON
+  #include <SPI.h>
+  #define SPI_HW_CLOCK 2000000                               // TMC drivers are good to about 4MHz on their internal clock
+  #ifdef ESP32
+    // SPI.begin() does nothing once the port is started, so the port stays on the pins it was first given
+    int sspiPortSck=-1, sspiPortMiso=-1, sspiPortMosi=-1;
+  #endif
+#endif
+
 class bbspi {
   public:
     void init(int cs, int sck, int miso, int mosi) {
       _cs=cs; _sck=sck; _miso=miso; _mosi=mosi;
+#if TMC_SPI_HARDWARE == ON
+  #ifdef ESP32
+      if (sspiPortSck < 0) {
+    #if (WEATHER == BME280_SPI || WEATHER == BMP280_SPI) && !defined(SSPI_SHARED)
+        // the weather sensor starts the port on its default pins
+        sspiPortSck=SCK; sspiPortMiso=MISO; sspiPortMosi=MOSI;
+    #else
+        sspiPortSck=_sck; sspiPortMiso=_miso; sspiPortMosi=_mosi;
+    #endif
+      }
+      _hw=(_sck == sspiPortSck && _mosi == sspiPortMosi && (_miso < 0 || _miso == sspiPortMiso));
+  #else
+      _hw=(_sck == SCK && _mosi == MOSI && (_miso < 0 || _miso == MISO));
+  #endif
+#endif
     }
 
+    // true if the hardware SPI port is used
+    bool hardware() { return _hw; }
+
     bool begin()
     {
+#if TMC_SPI_HARDWARE == ON
+      if (_hw) {
+        if (!_started) {
+          pinMode(_cs,OUTPUT); digitalWrite(_cs,HIGH);
+          startPort();
+          _started=true;
+        }
+  #ifdef SSPI_SHARED
+        // the pins are shared with other soft SPI devices, so the port only holds them for the transaction
+        else startPort();
+  #endif
+        SPI.beginTransaction(SPISettings(SPI_HW_CLOCK,MSBFIRST,SPI_MODE3));
+        digitalWrite(_cs,LOW);
+        delayMicroseconds(1);
+        return true;
+      }
+#endif
       pinMode(_cs,OUTPUT); digitalWrite(_cs,HIGH);
       delaySPI;
       pinMode(_sck,OUTPUT); digitalWrite(_sck,HIGH);
@@ -19,24 +65,47 @@ class bbspi {
       delaySPI;
       digitalWrite(_cs,LOW);
       delaySPI;
-      
+
       return true;
     }
-    
+
     void pause() {
+#if TMC_SPI_HARDWARE == ON
+      if (_hw) {
+        digitalWrite(_cs, HIGH);
+        delayMicroseconds(1);
+        digitalWrite(_cs, LOW);
+        delayMicroseconds(1);
+        return;
+      }
+#endif
       digitalWrite(_cs, HIGH);
       delaySPI;
       digitalWrite(_cs, LOW);
       delaySPI;
     }
-    
+
     void end() {
+#if TMC_SPI_HARDWARE == ON
+      if (_hw) {
+        digitalWrite(_cs, HIGH);
+        SPI.endTransaction();
+  #ifdef SSPI_SHARED
+        SPI.end();
+  #endif
+        delayMicroseconds(1);
+        return;
+      }
+#endif
       digitalWrite(_cs, HIGH);
       delaySPI;
     }
-    
+
     uint8_t transfer(uint8_t data_out)
     {
+#if TMC_SPI_HARDWARE == ON
+      if (_hw) return SPI.transfer(data_out);
+#endif
       uint8_t data_in = 0;
       for(int i=7; i >= 0; i--)
       {
@@ -47,12 +116,19 @@ class bbspi {
         if (_miso >= 0) bitWrite(data_in,i,digitalRead(_miso));
         delaySPI;
       }
-      
+
       return data_in;
     }
-    
+
     uint32_t transfer32(uint32_t data_out)
     {
+#if TMC_SPI_HARDWARE == ON
+      if (_hw) {
+        uint32_t data_in = 0;
+        for (int i=24; i >= 0; i-=8) data_in|=((uint32_t)SPI.transfer((data_out >> i) & 0xff)) << i;
+        return data_in;
+      }
+#endif
       uint32_t data_in = 0;
       for(int i=31; i >= 0; i--)
       {
@@ -66,9 +142,21 @@ class bbspi {
 
       return data_in;
     }
-  private:  
+  private:
+#if TMC_SPI_HARDWARE == ON
+    void startPort() {
+  #ifdef ESP32
+      SPI.begin(_sck,_miso,_mosi,-1);
+  #else
+      SPI.begin();
+  #endif
+    }
+#endif
+
     int _cs = 0;
     int _sck = 0;
     int _miso = 0;
     int _mosi = 0;
+    bool _hw = false;
+    bool _started = false;
 };
@@ -0,0 +1,180 @@
+// -----------------------------------------------------------------------------------
+// Step generator, steps the rotator and focuser motors from a hardware timer with acceleration ramps
+// the owner asks for a number of steps and collects the steps taken, the generator ramps up from a start rate,
+// cruises at the maximum rate, and ramps down to arrive at the requested position
+// with the S_CURVE profile the acceleration eases in and out, it is highest at half the maximum rate, either profile ramps in the same time
+// backlash (preload) steps at the start of a move are taken at the maximum rate before the move ramps up
+
+#pragma once
+
+#include "AuxTimer.h"
+
+#define STEP_GENERATOR_AXES 3
+#ifdef HAL_AUX_TIMER
+  #define STEP_GENERATOR_MICROS HAL_AUX_TIMER_MICROS         // timer tick period
+#else
+  #define STEP_GENERATOR_MICROS 100L                         // no timer, ticks are run from follow() and limited to the loop rate
+#endif
+#ifndef STEP_GENERATOR_RAMP
+  #define STEP_GENERATOR_RAMP 100L                           // time in milli-seconds to accelerate from the start rate to the maximum rate
+#endif
+#define STEP_GENERATOR_START_DIVISOR 10L                     // start/stop rate is 1/10 of the maximum rate
+#define STEP_GENERATOR_ONE 65536UL                           // rates are in steps per tick * 65536
+
+typedef struct {
+  int stepPin;
+  int dirPin;
+  int forwardState;
+  bool stepHigh;
+  int dir;                                                   // direction the motor is moving in, 0 when stopped
+  int profile;                                               // OFF (constant rate,) TRAPEZOID, or S_CURVE
+  long rampTicks;
+  unsigned long rate;
+  unsigned long rateMax;
+  unsigned long rateMin;
+  unsigned long accel;                                       // rate change per tick
+  unsigned long phase;
+  long rampSteps;                                            // steps taken while accelerating, this many steps are needed to stop
+  volatile long pending;                                     // steps still to take, + forward or - reverse
+  volatile long preload;                                     // of these, steps to take at the maximum rate first
+  volatile long steps;                                       // steps taken and not yet collected by the owner
+} StepAxis;
+
+IRAM_ATTR void stepGeneratorTick();
+
+class stepGenerator {
+  public:
+    // adds a motor with maxRate in milli-seconds per step, attaches to the auxiliary timer on first use, returns the handle or -1 if full
+    int attach(int stepPin, int dirPin, float maxRate) {
+      if (axisCount >= STEP_GENERATOR_AXES) return -1;
+      StepAxis *a=&axis[axisCount];
+      a->stepPin=stepPin; a->dirPin=dirPin; a->forwardState=HIGH;
+      a->stepHigh=false; a->dir=0; a->rate=0; a->phase=0; a->rampSteps=0; a->pending=0; a->preload=0; a->steps=0;
+      a->profile=TRAPEZOID; a->rampTicks=(STEP_GENERATOR_RAMP*1000L)/STEP_GENERATOR_MICROS;
+      digitalWrite(stepPin,LOW);
+      setRate(axisCount,maxRate);
+      cli(); axisCount++; sei();
+#ifdef HAL_AUX_TIMER
+      if (!started) { auxTimer.attach(stepGeneratorTick); started=true; }
+#endif
+      return axisCount-1;
+    }
+
+    // sets the maximum rate in milli-seconds per step, limited to one step every two ticks
+    void setRate(int h, float maxRate) {
+      if (h < 0) return;
+      unsigned long r=STEP_GENERATOR_ONE/2UL;
+      if (maxRate > 0.0) { double d=((double)STEP_GENERATOR_ONE*STEP_GENERATOR_MICROS)/(maxRate*1000.0); if (d < r) r=(unsigned long)d; }
+      if (r < 1) r=1;
+      unsigned long m=r/STEP_GENERATOR_START_DIVISOR; if (m < 1) m=1;
+      if (axis[h].profile == OFF) m=r;
+      // the S_CURVE shaping averages 64/105 of the peak acceleration from the start rate to the maximum rate, scale it up to ramp in the same time
+      unsigned long a=r-m; if (axis[h].profile == S_CURVE) a=(a*105UL)/64UL;
+      a/=axis[h].rampTicks; if (a < 1) a=1;
+      cli(); axis[h].rateMax=r; axis[h].rateMin=m; axis[h].accel=a; sei();
+    }
+
+    // sets the velocity profile and the time in milli-seconds to accelerate to the maximum rate, call setRate() after
+    void setProfile(int h, int profile, long rampMs) {
+      if (h < 0) return;
+      long t=(rampMs*1000L)/STEP_GENERATOR_MICROS; if (t < 1) t=1;
+      cli(); axis[h].profile=profile; axis[h].rampTicks=t; sei();
+    }
+
+    // logic state of the direction pin for forward steps
+    void setForwardState(int h, int state) { if (h >= 0) axis[h].forwardState=state; }
+
+    // asks for n more steps from the current position, the first preload of them at the maximum rate, replaces any earlier request
+    void request(int h, long n, long preload=0) {
+      if (h < 0) return;
+      cli();
+      long s=axis[h].steps;
+      axis[h].pending=n-s;
+      if (s < 0) s=-s; preload-=s; if (preload < 0) preload=0;
+      axis[h].preload=preload;
+      sei();
+    }
+
+    // returns the steps taken since the last call, + forward or - reverse, all in one direction
+    long collect(int h) {
+      if (h < 0) return 0;
+      cli(); long s=axis[h].steps; axis[h].steps=0; sei();
+      return s;
+    }
+
+    // true while steps are pending or the motor is still slowing down
+    bool busy(int h) {
+      if (h < 0) return false;
+      cli(); bool b=axis[h].pending != 0 || axis[h].dir != 0; sei();
+      return b;
+    }
+
+    // runs a tick from the main loop when there is no hardware timer
+    void poll() {
+#ifndef HAL_AUX_TIMER
+      unsigned long now=micros();
+      if ((long)(now-lastTick) < STEP_GENERATOR_MICROS) return;
+      lastTick=now;
+      cli(); tick(); sei();
+#endif
+    }
+
+    // called every STEP_GENERATOR_MICROS, a step pulse is high for one tick and the direction pin is set a tick ahead
+    IRAM_ATTR void tick() {
+      for (int i=0; i < axisCount; i++) {
+        StepAxis *a=&axis[i];
+        if (a->stepHigh) { digitalWrite(a->stepPin,LOW); a->stepHigh=false; continue; }
+
+        long p=a->pending;
+        int d=0; if (p > 0) d=1; else if (p < 0) d=-1;
+
+        // slow down and stop before changing direction, the owner collects the steps of one direction first
+        if (d != a->dir) {
+          if (a->rate > a->rateMin) { a->rate-=a->accel; if (a->rate < a->rateMin) a->rate=a->rateMin; continue; }
+          if (a->dir != 0 && a->steps != 0) continue;
+          a->rate=0; a->phase=0; a->rampSteps=0; a->dir=d;
+          if (d != 0) digitalWrite(a->dirPin,(d > 0)?a->forwardState:!a->forwardState);
+          continue;
+        }
+        if (d == 0) continue;
+
+        // backlash preload at the maximum rate, then ramp up, cruise, or ramp down to arrive at the target
+        int ramp=0;
+        if (a->preload > 0) { a->rate=a->rateMax; ramp=2; } else
+        if (a->rate == 0) a->rate=a->rateMin; else {
+          unsigned long accel=a->accel;
+          if (a->profile == S_CURVE && a->rate < a->rateMax) {
+            unsigned long t=(a->rate*(a->rateMax-a->rate))/a->rateMax;
+            accel=(a->accel*4UL*t)/a->rateMax; if (accel < a->accel/4UL) accel=a->accel/4UL; if (accel < 1) accel=1;
+          }
+          if ((d > 0 ? p : -p) <= a->rampSteps || a->rate > a->rateMax) {
+            if (a->rate > a->rateMin+accel) a->rate-=accel; else a->rate=a->rateMin;
+            ramp=-1;
+          } else
+          if (a->rate < a->rateMax) {
+            a->rate+=accel; if (a->rate > a->rateMax) a->rate=a->rateMax;
+            ramp=1;
+          }
+        }
+
+        a->phase+=a->rate;
+        if (a->phase >= STEP_GENERATOR_ONE) {
+          a->phase-=STEP_GENERATOR_ONE;
+          digitalWrite(a->stepPin,HIGH); a->stepHigh=true;
+          a->pending-=d; a->steps+=d;
+          if (ramp == 2) { if (--a->preload == 0) { a->rate=a->rateMin; a->rampSteps=0; } } else
+          if (ramp > 0) a->rampSteps++; else if (ramp < 0 && a->rampSteps > 0) a->rampSteps--;
+        }
+      }
+    }
+
+  private:
+    StepAxis axis[STEP_GENERATOR_AXES];
+    volatile int axisCount=0;
+    bool started=false;
+    unsigned long lastTick=0;
+};
+
+stepGenerator stepGen;
+
+IRAM_ATTR void stepGeneratorTick() { stepGen.tick(); }
@@ -1,5 +1,6 @@
 // -----------------------------------------------------------------------------------
 // Control Trinamic SPI mode stepper drivers
+// register writes are shadowed so only changes go out, a driver reset (reported in the status byte) clears the shadows
 
 #pragma once
 
@@ -18,10 +19,10 @@ class tmcSpiDriver {
     // decay mode:           decay_mode (STEALTHCHOP or SPREADCYCLE)
     // microstepping mode:   micro_step_mode (0=256x, 1=128x, 2=64x, 3=32x, 4=16x, 5=8x, 6=4x, 7=2x, 8=1x)
     // irun, ihold, rsense:  current in mA and sense resistor value
+    // registers that haven't changed since they were last written are skipped, the rest are written in one transaction
     bool setup(bool intpol, int decay_mode, byte micro_step_mode, int irun, int ihold) {
-      
-      if (!BBSpi.begin()) return false;
       uint32_t data_out=0;
+      pendingCount=0;
 
       // *** My notes are limited, see the TMC2130 datasheet for more info. ***
     
@@ -41,32 +42,28 @@ class tmcSpiDriver {
       data_out=(IHOLD<<0)+(IRUN<<8)+(4UL<<16);
       if (last_IHOLD_IRUN != data_out) {
         last_IHOLD_IRUN=data_out;
-        write(REG_IHOLD_IRUN,data_out);
-        BBSpi.pause();
+        queue(REG_IHOLD_IRUN,data_out);
       }
 
       // TPOWERDOWN, default=127, range 0 to 255 (Delay after standstill for motor current power down, about 0 to 4 seconds)
       data_out=(_tpd_value<<0);
       if (last_TPOWERDOWN != data_out) {
         last_TPOWERDOWN = data_out;
-        write(REG_TPOWERDOWN,data_out);
-        BBSpi.pause();
+        queue(REG_TPOWERDOWN,data_out);
       }
 
       // TPWMTHRS, default=0, range 0 to 2^20 (switchover upper velocity for stealthChop voltage PWM mode)
       data_out=(_tpt_value<<0);
       if (last_TPWMTHRS != data_out) {
         last_TPWMTHRS = data_out;
-        write(REG_TPWMTHRS,data_out);
-        BBSpi.pause();
+        queue(REG_TPWMTHRS,data_out);
       }
 
       // THIGH, default=0, range 0 to 2^20 (switchover rate for vhighfs/vhighchm)
       data_out=(_thigh_value<<0);
       if (last_THIGH != data_out) {
         last_THIGH = data_out;
-        write(REG_THIGH,data_out);
-        BBSpi.pause();
+        queue(REG_THIGH,data_out);
       }
 
       // PWMCONF
@@ -75,8 +72,7 @@ class tmcSpiDriver {
         data_out = (_pc_PWM_AMPL<<0)+(_pc_PWM_GRAD<<8)+(_pc_pwm_freq<<16)+(_pc_pwm_auto<<18)+(_pc_pwm_sym<<19)+(_pc_pwm_freewheel<<20);
         if (last_PWMCONF != data_out) {
           last_PWMCONF = data_out;
-          write(REG_PWMCONF,data_out);
-          BBSpi.pause();
+          queue(REG_PWMCONF,data_out);
         }
       } else
       if (_driver_model == TMC5160) {
@@ -84,8 +80,7 @@ class tmcSpiDriver {
         data_out = (_pc_PWM_OFS<<0)+(_pc_PWM_GRAD<<8)+(_pc_pwm_freq<<16)+(_pc_pwm_auto<<18)+(_pc_pwm_autograd<<19)+(_pc_pwm_freewheel<<20)+(_pc_PWM_REG<<24)+(_pc_PWM_LIM<<28);
         if (last_PWMCONF != data_out) {
           last_PWMCONF = data_out;
-          write(REG_PWMCONF,data_out);
-          BBSpi.pause();
+          queue(REG_PWMCONF,data_out);
         }
       }
 
@@ -97,8 +92,10 @@ class tmcSpiDriver {
       if (_driver_model == TMC5160) _last_chop_config=(_cc_toff<<0)+(_cc_hstart<<4)+(_cc_hend<<7)+(_cc_tbl<<15)+(_cc_vhighfs<<18)+(_cc_vhighchm<<19)+(_cc_tpfd<<20)+(_cc_intpol<<28);
       if (micro_step_mode != 255) {
         data_out=_last_chop_config + (((uint32_t)micro_step_mode)<<24);
-        write(REG_CHOPCONF,data_out);
-        BBSpi.pause();
+        if (last_CHOPCONF != data_out) {
+          last_CHOPCONF = data_out;
+          queue(REG_CHOPCONF,data_out);
+        }
       }
 
       // GCONF
@@ -108,9 +105,15 @@ class tmcSpiDriver {
       if (decay_mode == STEALTHCHOP) data_out |= 0x00000004UL;
       if (last_GCONF != data_out) {
         last_GCONF=data_out;
-        write(REG_GCONF,data_out);
+        queue(REG_GCONF,data_out);
       }
 
+      if (pendingCount == 0) return true;
+      if (!BBSpi.begin()) { invalidate(); return false; }
+      for (int i=0; i < pendingCount; i++) {
+        if (i > 0) BBSpi.pause();
+        write(pendingReg[i],pendingData[i]);
+      }
       BBSpi.end();
       return true;
     }
@@ -122,6 +125,13 @@ class tmcSpiDriver {
       uint32_t data_out=0;
       uint8_t result=read(REG_GSTAT,&data_out);
 
+      // the driver was reset (power loss for example,) forget what was written so the next setup() writes everything again
+      if ((result&1) != 0) {
+        invalidate();
+        BBSpi.pause();
+        write(REG_GSTAT,0x07UL);
+      }
+
       BBSpi.end();
       if ((result&2) != 0) return true; else return false;
       return true;
@@ -136,9 +146,12 @@ class tmcSpiDriver {
       // default=0x10410150UL
       if (_driver_model == TMC5160) _last_chop_config=(_cc_toff<<0)+(_cc_hstart<<4)+(_cc_hend<<7)+(_cc_tbl<<15)+(_cc_vhighfs<<18)+(_cc_vhighchm<<19)+(_cc_tpfd<<20)+(_cc_intpol<<28);
 
+      uint32_t data_out=_last_chop_config + (((uint32_t)micro_step_mode)<<24);
+      if (last_CHOPCONF == data_out) return true;
       if (!BBSpi.begin()) return false;
-      write(REG_CHOPCONF,_last_chop_config + (((uint32_t)micro_step_mode)<<24));
+      write(REG_CHOPCONF,data_out);
       BBSpi.end();
+      last_CHOPCONF = data_out;
       return true;
     }
 
@@ -222,10 +235,11 @@ class tmcSpiDriver {
       _s2gb=(bool)bitRead(data_out,27);      // DRV_STATUS 27 Short to Ground A
       _otpw=(bool)bitRead(data_out,26);      // DRV_STATUS 26 Overtemperature Pre-warning 120C
       _ot  =(bool)bitRead(data_out,25);      // DRV_STATUS 25 Overtemperature Shutdown 150C
-      _stallGuard=(bool)bitRead(data_out,24);// DRV_STATUS 24 Overtemperature Shutdown 150C
-      _CS_ACTUAL=(data_out>>16)&0b011111;    // DRV_STATUS 16 stallGuard2 status
+      _stallGuard=(bool)bitRead(data_out,24);// DRV_STATUS 24 stallGuard2 status
+      _CS_ACTUAL=(data_out>>16)&0b011111;    // DRV_STATUS 16 Actual motor current scale (CoolStep)
       _fsactive =(bool)bitRead(data_out,15); // DRV_STATUS 15 Full step active indicator
       _SG_RESULT=data_out&0b1111111111;      // DRV_STATUS  0 stallGuard2 result
+      sgResult=_SG_RESULT;
 
       BBSpi.end();
       return sgResult;
@@ -265,7 +279,17 @@ class tmcSpiDriver {
     bool set_COOLCONF_sfilt(int v)  { if ((v >= 0) && (v <= 1))    { _ccf_sfilt =v; return true; } return false; }
 
   private:
-    
+    // adds a register write to the transaction setup() sends
+    void queue(byte Address, uint32_t data_out) {
+      if (pendingCount >= 8) return;
+      pendingReg[pendingCount]=Address; pendingData[pendingCount]=data_out; pendingCount++;
+    }
+
+    // the driver's registers are unknown, they'll all be written again
+    void invalidate() {
+      last_GCONF=last_IHOLD_IRUN=last_TPOWERDOWN=last_TPWMTHRS=last_THIGH=last_PWMCONF=last_CHOPCONF=0xFFFFFFFFUL;
+    }
+
     uint8_t write(byte Address, uint32_t data_out)
     {
       Address=Address|0x80;
@@ -306,6 +330,12 @@ class tmcSpiDriver {
     unsigned long last_TPWMTHRS   = 0;
     unsigned long last_THIGH      = 0;
     unsigned long last_PWMCONF    = 0;
+    unsigned long last_CHOPCONF   = 0xFFFFFFFFUL;
+
+// registers setup() is about to write
+    byte pendingReg[8];
+    uint32_t pendingData[8];
+    int pendingCount = 0;
 
 // CHOPCONF settings
     unsigned long _cc_toff      = 4UL; // default=4,   range 2 to 15 (Off time setting, slow decay phase)
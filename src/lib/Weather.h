@@ -4,6 +4,7 @@
 #pragma once
 
 #include "Heater.h"
+#include "SensorFilter.h"
 
 #if WEATHER != OFF
 
@@ -48,12 +49,24 @@
     #include <DallasGPIO.h>               // my modified DallasGPIO library https://github.com/hjd1964/Arduino-DS2413GPIO-Control-Library
     DallasGPIO DS2413GPIO(&oneWire);
   #endif
+
+  // DS1820 conversions and reads are timed from the auxiliary timer where there is one
+  #if defined(DS1820_DEVICES_PRESENT) && defined(HAL_AUX_TIMER)
+    #define DS1820_ASYNC
+    #include "OneWireBus.h"
+  #endif
 #endif
 
 class weather {
   public:
     bool init() {
       bool success = true;
+
+      // time constant (s), reported change, ignored spike, and stale time (ms) for each channel
+      tAmbient.init(20.0,0.25,5.0,30000);
+      tTelescope.init(20.0,0.1,5.0,30000);
+      pAmbient.init(60.0,0.5,20.0,30000);
+      hAmbient.init(30.0,1.0,20.0,30000);
 #ifdef ONEWIRE_DEVICES_PRESENT
       uint8_t address[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
@@ -161,6 +174,9 @@ class weather {
 
       if (_DS1820_devices > 0) _DS1820_found = true;
       if (_DS2413_devices > 0) _DS2413_found = true;
+  #ifdef DS1820_ASYNC
+      if (_DS1820_found && !owBus.init(OneWirePin)) DLF("WRN, ambient.init(): no auxiliary timer for the OneWire bus, DS1820 reads are blocking");
+  #endif
 #endif
 #if WEATHER != OFF
   #if WEATHER == BME280
@@ -189,16 +205,44 @@ class weather {
     }
 
     // designed for a 0.01s polling interval, 5 seconds to refresh everything
-    void poll() {
-      static bool firstScanDone = false;
+    // while slewing only the transfers that leave interrupts enabled run, the I2C/SPI sensor and the timer driven DS1820
+    // reads (those mask interrupts for about 10us at a time)
+    void poll(bool slewing) {
 #if WEATHER != OFF || defined(ONEWIRE_DEVICES_PRESENT)
       if (_BME280_found || _BMP280_found || _DS1820_found || _DS2413_found) {
 
+  #if WEATHER != OFF
+        // the I2C/SPI sensor has its own sequence, one short transfer per call
+        if (_BME280_found || _BMP280_found) {
+          static int busPhase = 0;
+          bool transfer = true;
+          if (busPhase == 4) _t = bmx.readTemperature(); else
+          if (busPhase == 8) _p = bmx.readPressure() / 100.0; else
+    #if WEATHER == BME280 || WEATHER == BME280_0x76 || WEATHER == BME280_SPI
+          if (busPhase == 12) _h = bmx.readHumidity(); else
+    #endif
+          transfer = false;
+          if (++busPhase >= 500) busPhase = 0;
+          if (transfer) return;
+        }
+    #if WEATHER_SUPRESS_ERRORS == OFF
+        else { _t=NAN; _p=NAN; _h=NAN; }
+    #endif
+  #endif
+
         static int phase = 0;
-        if (phase >= 500) { phase = 0; _DS1820_count = 0; firstScanDone = true; }
+        if (phase >= 500) { phase = 0; _DS1820_count = 0; _firstScanDone = true; }
+
+  #ifdef ONEWIRE_DEVICES_PRESENT
+        // the OneWire library masks interrupts for each bit, so it waits until the slew is done
+        bool libraryBusy = slewing;
+    #ifdef DS1820_ASYNC
+        if (owBus.busy()) libraryBusy = true;
+    #endif
+  #endif
 
   #ifdef DS2413_DEVICES_PRESENT
-        if (_DS2413_found) {
+        if (_DS2413_found && !libraryBusy) {
           if (phase%2 == 0) for (int i=0; i<8; i++) _this_ds2413_state[i]=_ds2413_state[i];
     #if (FEATURE1_PIN & DS_MASK) == DS2413 || (FEATURE2_PIN & DS_MASK) == DS2413
           if (phase%2 == 1 && (_last_ds2413_state[1] != _this_ds2413_state[1] || _last_ds2413_state[0] != _this_ds2413_state[0])) {
@@ -233,54 +277,41 @@ class weather {
 
   #ifdef DS1820_DEVICES_PRESENT
         if (_DS1820_found) {
-          float f;
-          if (phase == 0) { if (DS18B20.requestTemperatures(true)) phase++; return; }
+          if (phase == 0) { if (DSconvert(libraryBusy)) phase++; return; }
     #if TELESCOPE_TEMPERATURE != OFF
-          if (phase == 50) { f = DS18B20.getTempC(_DS1820_address[0],true); if (Tpolling(f)) return; else { _DS1820_count++; _tt=Tvalidated(f); phase++; return; } }
+          if (phase == 50) { if (DSread(0,&_tt,libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE1_TEMP & DS_MASK) == DS1820
-          if (phase == 100) { f = DS18B20.getTempC(_DS1820_address[1],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[0]=Tvalidated(f); phase++; return; } }
+          if (phase == 100) { if (DSread(1,&_dh_t[0],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE2_TEMP & DS_MASK) == DS1820
-          if (phase == 150) { f = DS18B20.getTempC(_DS1820_address[2],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[1]=Tvalidated(f); phase++; return; } }
+          if (phase == 150) { if (DSread(2,&_dh_t[1],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE3_TEMP & DS_MASK) == DS1820
-          if (phase == 200) { f = DS18B20.getTempC(_DS1820_address[3],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[2]=Tvalidated(f); phase++; return; } }
+          if (phase == 200) { if (DSread(3,&_dh_t[2],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE4_TEMP & DS_MASK) == DS1820
-          if (phase == 250) { f = DS18B20.getTempC(_DS1820_address[4],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[3]=Tvalidated(f); phase++; return; } }
+          if (phase == 250) { if (DSread(4,&_dh_t[3],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE5_TEMP & DS_MASK) == DS1820
-          if (phase == 300) { f = DS18B20.getTempC(_DS1820_address[5],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[4]=Tvalidated(f); phase++; return; } }
+          if (phase == 300) { if (DSread(5,&_dh_t[4],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE6_TEMP & DS_MASK) == DS1820
-          if (phase == 350) { f = DS18B20.getTempC(_DS1820_address[6],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[5]=Tvalidated(f); phase++; return; } }
+          if (phase == 350) { if (DSread(6,&_dh_t[5],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE7_TEMP & DS_MASK) == DS1820
-          if (phase == 400) { f = DS18B20.getTempC(_DS1820_address[7],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[6]=Tvalidated(f); phase++; return; } }
+          if (phase == 400) { if (DSread(7,&_dh_t[6],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
     #if (FEATURE8_TEMP & DS_MASK) == DS1820
-          if (phase == 450) { f = DS18B20.getTempC(_DS1820_address[8],true); if (Tpolling(f)) return; else { _DS1820_count++; _dh_t[7]=Tvalidated(f); phase++; return; } }
+          if (phase == 450) { if (DSread(8,&_dh_t[7],libraryBusy)) { _DS1820_count++; phase++; } return; }
     #endif
         }
   #endif
 
-  #if WEATHER != OFF
-        if (_BME280_found || _BMP280_found) {
-          if (phase == 4) { _t = bmx.readTemperature(); phase++; return; }
-          if (phase == 8) { _p = bmx.readPressure() / 100.0; phase++; return; }
-    #if WEATHER == BME280 || WEATHER == BME280_0x76 || WEATHER == BME280_SPI
-          if (phase == 12) { _h = bmx.readHumidity(); phase++; return; }
-    #endif
-        }
-    #if WEATHER_SUPRESS_ERRORS == OFF
-        else { _t=NAN; _p=NAN; _h=NAN; }
-    #endif
-  #endif
       phase++;
       }
 #endif
-      if (!firstScanDone) return;
+      if (!_firstScanDone) return;
       
 #if TELESCOPE_TEMPERATURE == OFF
       // use primary temperature for the telescope temperature if TELESCOPE_TEMPERATURE
@@ -295,34 +326,15 @@ class weather {
       // once every two second timed
       static uint16_t p = 1;
       if ((p++)%200 == 0) {
-        // apply a 10 sample rolling average to the ambient temperature
-        static byte taNanCount=0;
-        static bool firstTSample=true; if (firstTSample) { firstTSample=false; _ta=_t; if (!isnan(_t)) taNanCount=0; }
-        if (isnan(_t)) {
-          if (taNanCount < 15) {
-            taNanCount++;
-            VLF("WRN, misc. comms: ambient temp");
-          } else {
-            _ta=NAN;
-            firstTSample=true;
-            VLF("WRN, misc. isnan: ambient temp disabled");
-          }
-        } else { taNanCount=0; _ta=(_ta*9.0+_t)/10.0; }
-
-        // apply a 10 sample rolling average to the telescope temperature
-        static byte ttNanCount=0;
-        static bool firstTTSample=true; if (firstTTSample) { firstTTSample=false; _tta=_tt; if (!isnan(_tt)) ttNanCount=0; }
-        if (isnan(_tt)) {
-          if (ttNanCount < 15) {
-            ttNanCount++;
-            VLF("WRN, DS1820 comms: telescope");
-          } else {
-            _tta=NAN;
-            firstTTSample=true;
-            VLF("WRN, DS1820 isnan: telescope disabled");
-          }
-        } else { ttNanCount=0; _tta=(_tta*9.0+_tt)/10.0; }
- 
+        // filter the readings, a channel that stops getting good readings goes stale and its fallback is used
+        tAmbient.update(_t);
+        tTelescope.update(_tt);
+        pAmbient.update(_p);
+        hAmbient.update(_h);
+        static bool taStale=false, ttStale=false;
+        if (tAmbient.fresh() == taStale) { taStale=!taStale; if (taStale) VLF("WRN, misc. stale: ambient temp, using fallback"); else VLF("MSG, misc. ambient temp restored"); }
+        if (tTelescope.fresh() == ttStale) { ttStale=!ttStale; if (ttStale) VLF("WRN, DS1820 stale: telescope temp disabled"); else VLF("MSG, DS1820 telescope temp restored"); }
+
  #ifdef DS1820_DEVICES_PRESENT
         // apply a 2 sample rolling average to the feature temperatures
         static byte ftNanCount[8]={0,0,0,0,0,0,0,0};
@@ -388,15 +400,22 @@ class weather {
 #endif
     }
 
-    // get temperature in deg. C
+    // get temperature in deg. C, from the weather sensor, the telescope temperature sensor if that fails, or the default
     float getTemperature() {
-      return _ta;
+      if (tAmbient.fresh()) return tAmbient.getReported();
+      if (tTelescope.fresh()) return tTelescope.getReported();
+      return 10.0;
     }
     
-    // get telescope temperature in deg. C
+    // get telescope temperature in deg. C, NAN once the sensor fails
     float getTelescopeTemperature() {
-      return _tta;
+      if (tTelescope.fresh()) return tTelescope.getReported();
+      if (!_firstScanDone) return 10.0;
+      return NAN;
     }
+
+    // counts the changes of the telescope temperature that are large enough to report
+    uint16_t getTelescopeChanges() { return tTelescope.getChanges(); }
     
     // get feature temperature in deg. C
     float getFeatureTemperature(int index) {
@@ -431,26 +450,32 @@ class weather {
     // set temperature in deg. C
     void setTemperature(float t) {
       _t = t;
+      tAmbient.set(t);
     }
     
-    // get barometric pressure in hPa/mb
+    // get barometric pressure in hPa/mb, if the sensor fails the standard atmosphere at the site altitude
     float getPressure() {
-      return _p;
+      if (pAmbient.fresh()) return pAmbient.getReported();
+      return 1013.25*pow(1.0-2.25577e-5*_a,5.25588);
     }
     
     // get barometric pressure in hPa/mb
     void setPressure(float p) {
       _p = p;
+      pAmbient.set(p);
     }
     
-    // get relative humidity in %
+    // get relative humidity in %, NAN once the sensor fails
     float getHumidity() {
-      return _h;
+      if (hAmbient.fresh()) return hAmbient.getReported();
+      if (!_firstScanDone) return 70.0;
+      return NAN;
     }
     
     // set relative humidity in %
     void setHumidity(float h) {
       _h = h;
+      hAmbient.set(h);
     }
     
     // get altitude in meters
@@ -466,7 +491,7 @@ class weather {
     // get dew point in deg. C
     // accurate to +/- 1 deg. C for RH above 50%
     float getDewPoint() {
-      return _ta - ((100.0 - _h) / 5.0);
+      return getTemperature() - ((100.0 - getHumidity()) / 5.0);
       // a more accurate formula?
       // return 243.04*(log(_h/100.0)+((17.625*_ta)/(243.04+_ta)))/(17.625-log(_h/100.0)-((17.625*_ta)/(243.04+_ta)));
     }
@@ -495,19 +520,27 @@ class weather {
     int  _DS1820_devices = 0;
     int  _DS1820_count = 0;
     uint8_t _DS1820_address[9][8];
+#ifdef DS1820_ASYNC
+    bool _DS1820_reading = false;
+    unsigned long _DS1820_convertMs = 0;
+#endif
 
     bool _DS2413_found = false;
     int  _DS2413_devices = 0;
     int  _DS2413_count = 0;
     uint8_t _DS2413_address[4][8];
 
+    bool _firstScanDone = false;
+
     float _t = 10.0;
-    float _ta = 10.0;
     float _p = 1010.0;
     float _h = 70.0;
     float _a = 200.0;
     float _tt = 10.0;
-    float _tta = 10.0;
+    sensorFilter tAmbient;
+    sensorFilter tTelescope;
+    sensorFilter pAmbient;
+    sensorFilter hAmbient;
     float _dh_t[8] = {NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN};
     float _dh_ta[8] = {NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN};
     bool _ds2413_state[8] = {false, false, false, false, false, false, false, false};
@@ -516,6 +549,41 @@ class weather {
     int16_t _last_ds2413_state[8] = {INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID};
 
 #ifdef DS1820_DEVICES_PRESENT
+    // starts a conversion on all DS1820 devices, returns true once started
+    bool DSconvert(bool libraryBusy) {
+  #ifdef DS1820_ASYNC
+      if (owBus.available()) {
+        if (!owBus.convert()) return false;
+        _DS1820_convertMs = millis();
+        return true;
+      }
+  #endif
+      if (libraryBusy) return false;
+      return DS18B20.requestTemperatures(true);
+    }
+
+    // reads DS1820 device i into t once its conversion is done, returns true when finished
+    bool DSread(int i, float *t, bool libraryBusy) {
+  #ifdef DS1820_ASYNC
+      if (owBus.available()) {
+        if (!_DS1820_reading) {
+          if ((long)(millis() - _DS1820_convertMs) < 750L) return false;
+          if (owBus.readScratchpad(_DS1820_address[i])) _DS1820_reading = true;
+          return false;
+        }
+        if (owBus.busy()) return false;
+        _DS1820_reading = false;
+        *t = Tvalidated(owBus.getTempC(_DS1820_address[i]));
+        return true;
+      }
+  #endif
+      if (libraryBusy) return false;
+      float f = DS18B20.getTempC(_DS1820_address[i],true);
+      if (Tpolling(f)) return false;
+      *t = Tvalidated(f);
+      return true;
+    }
+
     bool Tpolling(float f) {
       return (fabs(f-DEVICE_POLLING_C) < 0.001);
     }